@@ -0,0 +1,159 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+constexpr char CHECKPOINT_MAGIC[8]{ 'S', 'I', 'M', 'C', 'K', 'P', 'T', '\0' };
+constexpr std::uint32_t CHECKPOINT_VERSION{ 9 };
+constexpr std::size_t CHECKPOINT_HEADER_SIZE{ 72 };   // ends with the checksum of everything after the header
+
+/**
+ * FNV-1a over 64-bit words, the tail bytewise. Catches any corruption of a checkpoint payload before it is parsed.
+ */
+inline std::uint64_t CheckpointChecksum(const void* data, std::size_t length)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    std::uint64_t hash = 0xCBF29CE484222325ULL;
+    std::size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= length; i += sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001B3ULL;
+    }
+    for (; i < length; ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    return hash;
+}
+
+/**
+ * Throws std::runtime_error unless the restored state is consistent, for the checks a Load makes after reading.
+ */
+inline void CheckCheckpoint(bool consistent)
+{
+    if (!consistent)
+    {
+        throw std::runtime_error("Checkpoint is inconsistent\n");
+    }
+}
+
+/**
+ * True if a bool copied out of an image holds 0 or 1. Looks at the byte, loading any other value as a bool is undefined.
+ */
+inline bool IsBool(const bool& value)
+{
+    unsigned char byte;
+    std::memcpy(&byte, &value, 1);
+    return byte <= 1;
+}
+
+/**
+ * Appends the binary checkpoint image. Values are written in native byte order, arrays as a
+ * 64-bit element count followed by the raw elements, so restoring an array is a single memcpy.
+ */
+class CheckpointWriter
+{
+    private:
+        std::vector<unsigned char> data_;
+
+    public:
+        template<typename T>
+        void Write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Checkpoint values must be trivially copyable");
+            const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+            data_.insert(data_.end(), bytes, bytes + sizeof(T));
+        }
+
+        template<typename T>
+        void WriteArray(const T* values, std::size_t count)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Checkpoint values must be trivially copyable");
+            Write<std::uint64_t>(count);
+            const auto* bytes = reinterpret_cast<const unsigned char*>(values);
+            data_.insert(data_.end(), bytes, bytes + count * sizeof(T));
+        }
+
+        template<typename T>
+        void WriteVector(const std::vector<T>& values) { WriteArray(values.data(), values.size()); }
+
+        void WriteString(const std::string& value) { WriteArray(value.data(), value.size()); }
+
+        const std::vector<unsigned char>& Data() const { return data_; }
+        std::vector<unsigned char> Release() { return std::move(data_); }
+};
+
+/**
+ * Reads a checkpoint image in place, e.g. from a memory mapped file.
+ * Throws std::runtime_error if the image ends early or a bool isn't 0 or 1.
+ */
+class CheckpointReader
+{
+    private:
+        const unsigned char* next_;
+        const unsigned char* end_;
+
+        const unsigned char* Take(std::size_t bytes)
+        {
+            if (static_cast<std::size_t>(end_ - next_) < bytes)
+            {
+                throw std::runtime_error("Checkpoint is truncated\n");
+            }
+            const unsigned char* taken = next_;
+            next_ += bytes;
+            return taken;
+        }
+
+    public:
+        CheckpointReader(const void* data, std::size_t length)
+        :next_(static_cast<const unsigned char*>(data)),end_(next_ + length)
+        {
+        }
+
+        template<typename T>
+        T Read()
+        {
+            T value;
+            std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        bool ReadBool()
+        {
+            unsigned char value = Read<unsigned char>();
+            CheckCheckpoint(value <= 1);
+            return value != 0;
+        }
+
+        /**
+         * Reads an array written by WriteArray. The count is checked against the remaining bytes before anything is allocated.
+        */
+        template<typename T>
+        void ReadVector(std::vector<T>& values)
+        {
+            std::uint64_t count = Read<std::uint64_t>();
+            if (count > static_cast<std::uint64_t>(end_ - next_) / (sizeof(T) == 0 ? 1 : sizeof(T)))
+            {
+                throw std::runtime_error("Checkpoint is truncated\n");
+            }
+            values.resize(count);
+            if (count != 0)
+                std::memcpy(values.data(), Take(count * sizeof(T)), count * sizeof(T));
+        }
+
+        std::string ReadString()
+        {
+            std::uint64_t length = Read<std::uint64_t>();
+            const char* bytes = reinterpret_cast<const char*>(Take(length));
+            return std::string(bytes, length);
+        }
+
+        bool AtEnd() const { return next_ == end_; }
+};
+
+#endif
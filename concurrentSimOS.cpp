@@ -0,0 +1,279 @@
+#include "concurrentSimOS.h"
+
+ConcurrentSimOS::ConcurrentSimOS( int numberOfDisks, unsigned long long amountOfRAM, unsigned int pageSize, const SimOptions& options )
+:sim_(numberOfDisks, amountOfRAM, pageSize, options),cpus_(sim_.NumberOfCores())
+{
+    for (auto& cpu : cpus_)
+    {
+        cpu.store(NO_PROCESS, std::memory_order_relaxed);
+    }
+    PublishSnapshot();
+}
+
+std::uint64_t ConcurrentSimOS::Post( const SimEvent& event )
+{
+    return Submit(Command{event});
+}
+
+std::uint64_t ConcurrentSimOS::Submit(const Command& command)
+{
+    std::uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        ticket = nextTicket_++;
+        pending_.push_back(command);
+    }
+    Combine();
+    return ticket;
+}
+
+void ConcurrentSimOS::Combine()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> sequencer(applyMutex_, std::try_to_lock);
+        if (!sequencer.owns_lock())
+        {
+            // The thread holding it rechecks the queue before it lets go
+            return;
+        }
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex_);
+                batch_.swap(pending_);
+            }
+            if (batch_.empty())
+            {
+                break;
+            }
+            bool barrier = false;
+            for (const Command& command : batch_)
+            {
+                if (!command.barrier)
+                {
+                    try
+                    {
+                        Apply(command.event);
+                    }
+                    catch (...)
+                    {
+                        if (command.done == nullptr)
+                            rejected_.fetch_add(1, std::memory_order_relaxed);
+                        else
+                            command.done->set_exception(std::current_exception());
+                        ++applied_;
+                        continue;
+                    }
+                }
+                barrier = barrier || command.barrier;
+                ++applied_;
+                if (command.done != nullptr && !command.barrier)
+                    command.done->set_value();
+            }
+            PublishCPUs();
+            if (barrier || snapshotWanted_.exchange(false, std::memory_order_acq_rel))
+            {
+                PublishSnapshot();
+            }
+            // Barriers are released only after the snapshot they asked for is out
+            for (const Command& command : batch_)
+            {
+                if (command.barrier)
+                    command.done->set_value();
+            }
+            batch_.clear();
+        }
+        sequencer.unlock();
+
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (pending_.empty())
+        {
+            return;
+        }
+    }
+}
+
+void ConcurrentSimOS::Apply(const SimEvent& event)
+{
+    switch (event.op)
+    {
+        case TraceOp::NewProcess:          sim_.NewProcess(); break;
+        case TraceOp::SimFork:             sim_.SimFork(event.core); break;
+        case TraceOp::SimExit:             sim_.SimExit(event.core); break;
+        case TraceOp::SimWait:             sim_.SimWait(event.core); break;
+        case TraceOp::TimerInterrupt:      sim_.TimerInterrupt(event.core); break;
+        case TraceOp::DiskReadRequest:     sim_.DiskReadRequest(event.unit, static_cast<FileId>(event.arg), event.block, event.size, event.core); break;
+        case TraceOp::DiskJobCompleted:    sim_.DiskJobCompleted(event.unit); break;
+        case TraceOp::AccessMemoryAddress: sim_.AccessMemoryAddress(event.arg, event.core); break;
+        case TraceOp::WriteMemoryAddress:  sim_.WriteMemoryAddress(event.arg, event.core); break;
+        case TraceOp::ReadExtent:          break;
+    }
+}
+
+void ConcurrentSimOS::PublishCPUs()
+{
+    cpuVersion_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int core = 0; core < static_cast<int>(cpus_.size()); ++core)
+    {
+        cpus_[core].store(sim_.GetCPU(core), std::memory_order_relaxed);
+    }
+    cpuVersion_.fetch_add(1, std::memory_order_release);
+}
+
+void ConcurrentSimOS::PublishSnapshot()
+{
+    auto snapshot = std::make_shared<SimSnapshot>();
+    snapshot->sequence = applied_;
+    for (int core = 0; core < sim_.NumberOfCores(); ++core)
+    {
+        snapshot->cpus.push_back(sim_.GetCPU(core));
+        snapshot->readyQueues.push_back(sim_.GetReadyQueue(core));
+    }
+    snapshot->memory = sim_.GetMemory();
+    {
+        // Names are looked up while producers may be interning new ones
+        std::lock_guard<std::mutex> lock(namesMutex_);
+        for (int disk = 0; disk < static_cast<int>(sim_.NumberOfDisks()); ++disk)
+        {
+            snapshot->disks.push_back(sim_.GetDisk(disk));
+            snapshot->diskQueues.push_back(sim_.GetDiskQueue(disk));
+        }
+    }
+    std::atomic_store(&snapshot_, std::shared_ptr<const SimSnapshot>(std::move(snapshot)));
+}
+
+void ConcurrentSimOS::Call(const SimEvent& event)
+{
+    std::promise<void> done;
+    std::future<void> applied = done.get_future();
+    Submit(Command{event, false, &done});
+    applied.get();
+}
+
+void ConcurrentSimOS::NewProcess()
+{
+    Call(SimEvent{TraceOp::NewProcess});
+}
+
+void ConcurrentSimOS::SimFork( int core )
+{
+    Call(SimEvent{TraceOp::SimFork, 0, core});
+}
+
+void ConcurrentSimOS::SimExit( int core )
+{
+    Call(SimEvent{TraceOp::SimExit, 0, core});
+}
+
+void ConcurrentSimOS::SimWait( int core )
+{
+    Call(SimEvent{TraceOp::SimWait, 0, core});
+}
+
+void ConcurrentSimOS::TimerInterrupt( int core )
+{
+    Call(SimEvent{TraceOp::TimerInterrupt, 0, core});
+}
+
+void ConcurrentSimOS::DiskReadRequest( int diskNumber, const std::string& fileName, int core )
+{
+    DiskReadRequest(diskNumber, InternFileName(fileName), 0, 0, core);
+}
+
+void ConcurrentSimOS::DiskReadRequest( int diskNumber, FileId file, unsigned long long block, unsigned long long size, int core )
+{
+    Call(SimEvent{TraceOp::DiskReadRequest, diskNumber, core, file, block, size});
+}
+
+void ConcurrentSimOS::DiskJobCompleted( int diskNumber )
+{
+    Call(SimEvent{TraceOp::DiskJobCompleted, diskNumber});
+}
+
+void ConcurrentSimOS::AccessMemoryAddress( unsigned long long address, int core )
+{
+    Call(SimEvent{TraceOp::AccessMemoryAddress, 0, core, address});
+}
+
+void ConcurrentSimOS::WriteMemoryAddress( unsigned long long address, int core )
+{
+    Call(SimEvent{TraceOp::WriteMemoryAddress, 0, core, address});
+}
+
+FileId ConcurrentSimOS::InternFileName( std::string_view fileName )
+{
+    std::lock_guard<std::mutex> lock(namesMutex_);
+    return sim_.InternFileName(fileName);
+}
+
+void ConcurrentSimOS::Sync()
+{
+    std::promise<void> done;
+    std::future<void> published = done.get_future();
+    Submit(Command{SimEvent{}, true, &done});
+    published.get();
+}
+
+int ConcurrentSimOS::GetCPU( int core ) const
+{
+    if (core < 0 || core >= static_cast<int>(cpus_.size()))
+    {
+        throw std::out_of_range("Attempt to access out of bound core index\n");
+    }
+    while (true)
+    {
+        std::uint64_t before = cpuVersion_.load(std::memory_order_acquire);
+        int pid = cpus_[core].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((before & 1) == 0 && cpuVersion_.load(std::memory_order_relaxed) == before)
+            return pid;
+    }
+}
+
+std::shared_ptr<const SimSnapshot> ConcurrentSimOS::CurrentSnapshot()
+{
+    return std::atomic_load(&snapshot_);
+}
+
+std::shared_ptr<const SimSnapshot> ConcurrentSimOS::Snapshot()
+{
+    snapshotWanted_.store(true, std::memory_order_release);
+    return CurrentSnapshot();
+}
+
+std::deque<int> ConcurrentSimOS::GetReadyQueue( int core )
+{
+    auto snapshot = Snapshot();
+    if (core < 0 || core >= static_cast<int>(snapshot->readyQueues.size()))
+    {
+        throw std::out_of_range("Attempt to access out of bound core index\n");
+    }
+    return snapshot->readyQueues[core];
+}
+
+MemoryUsage ConcurrentSimOS::GetMemory()
+{
+    return Snapshot()->memory;
+}
+
+FileReadRequest ConcurrentSimOS::GetDisk( int diskNumber )
+{
+    auto snapshot = Snapshot();
+    if (diskNumber < 0 || diskNumber >= static_cast<int>(snapshot->disks.size()))
+    {
+        throw std::out_of_range("Attempt to access out of bound disk index\n");
+    }
+    return snapshot->disks[diskNumber];
+}
+
+std::deque<FileReadRequest> ConcurrentSimOS::GetDiskQueue( int diskNumber )
+{
+    auto snapshot = Snapshot();
+    if (diskNumber < 0 || diskNumber >= static_cast<int>(snapshot->diskQueues.size()))
+    {
+        throw std::out_of_range("Attempt to access out of bound disk index\n");
+    }
+    return snapshot->diskQueues[diskNumber];
+}
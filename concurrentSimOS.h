@@ -0,0 +1,158 @@
+#ifndef CONCURRENT_SIMOS_H
+#define CONCURRENT_SIMOS_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "simOS.h"
+#include "traceReplay.h"
+
+/**
+ * One SimOS call as posted by a producer thread. op and the fields used by it follow the trace format:
+ * unit is the disk, arg the address or the FileId of a read.
+ */
+struct SimEvent
+{
+    TraceOp op {TraceOp::NewProcess};
+    int unit {0};
+    int core {0};
+    unsigned long long arg {0};
+    unsigned long long block {0};
+    unsigned long long size {0};
+};
+
+/**
+ * Immutable copy of the observable state, published by the thread applying events.
+ * sequence is the number of events applied when it was taken.
+ */
+struct SimSnapshot
+{
+    std::uint64_t sequence {0};
+    std::vector<int> cpus;
+    std::vector<std::deque<int>> readyQueues;
+    MemoryUsage memory;
+    std::vector<FileReadRequest> disks;
+    std::vector<std::deque<FileReadRequest>> diskQueues;
+};
+
+/**
+ * Thread-safe front end of a SimOS for several producer threads.
+ *
+ * Every SimOS call touches state shared by all of them (cores, run queues, the frame pool and its
+ * replacement order), so calls are applied one at a time by a sequencer. Each posted event gets a
+ * ticket and events are applied in ticket order, so a run is reproducible from the ticket order alone.
+ * Posting only takes a short queue lock. Whichever producer finds the sequencer idle applies everything
+ * queued so far in one batch (flat combining), the others return, or wait for their own ticket when they
+ * used a blocking call.
+ *
+ * Queries never wait for the sequencer. GetCPU reads a seqlock the sequencer updates after every batch.
+ * The other queries read the latest published SimSnapshot (RCU style: readers keep the copy they loaded
+ * alive, the sequencer swaps in a new one). A snapshot is only rebuilt after some reader asked for one, so
+ * it can lag behind the writers. Sync() waits for everything posted so far and publishes a fresh one.
+ */
+class ConcurrentSimOS
+{
+    private:
+        struct Command
+        {
+            SimEvent event;
+            bool barrier {false};
+            std::promise<void>* done {nullptr};   // set by blocking calls, receives the SimOS exception
+        };
+
+        SimOS sim_;
+
+        std::mutex queueMutex_;
+        std::vector<Command> pending_;
+        std::uint64_t nextTicket_ {0};
+
+        std::mutex applyMutex_;                  // held by the thread acting as sequencer
+        std::vector<Command> batch_;
+        std::uint64_t applied_ {0};
+        std::atomic<std::uint64_t> rejected_ {0};
+
+        std::mutex namesMutex_;                  // file name table, shared with queries
+
+        std::atomic<std::uint64_t> cpuVersion_ {0};   // seqlock, odd while the sequencer writes
+        std::vector<std::atomic<int>> cpus_;
+
+        std::shared_ptr<const SimSnapshot> snapshot_;   // only accessed through std::atomic_load/store
+        std::atomic<bool> snapshotWanted_ {true};
+
+        /**
+         * Queues the command and returns its ticket, then applies the queue if no other thread is doing so.
+        */
+        std::uint64_t Submit(const Command& command);
+
+        void Combine();
+        void Apply(const SimEvent& event);
+        void PublishCPUs();
+        void PublishSnapshot();
+
+        /**
+         * Posts the event and waits until it is applied. Rethrows what SimOS threw.
+        */
+        void Call(const SimEvent& event);
+
+        std::shared_ptr<const SimSnapshot> CurrentSnapshot();
+
+    public:
+        ConcurrentSimOS( int numberOfDisks, unsigned long long amountOfRAM, unsigned int pageSize,
+            const SimOptions& options = SimOptions() );
+
+        /**
+         * Queues the event without waiting and returns its ticket. Events that make SimOS throw are
+         * dropped and counted by Rejected().
+        */
+        std::uint64_t Post( const SimEvent& event );
+
+        /**
+         * Blocking calls with the same meaning and exceptions as the SimOS ones.
+        */
+        void NewProcess();
+        void SimFork( int core = 0 );
+        void SimExit( int core = 0 );
+        void SimWait( int core = 0 );
+        void TimerInterrupt( int core = 0 );
+        void DiskReadRequest( int diskNumber, const std::string& fileName, int core = 0 );
+        void DiskReadRequest( int diskNumber, FileId file, unsigned long long block = 0,
+            unsigned long long size = 0, int core = 0 );
+        void DiskJobCompleted( int diskNumber );
+        void AccessMemoryAddress( unsigned long long address, int core = 0 );
+        void WriteMemoryAddress( unsigned long long address, int core = 0 );
+
+        /**
+         * File name interning for Post and the FileId overload, safe to call from any thread.
+        */
+        FileId InternFileName( std::string_view fileName );
+
+        /**
+         * Waits until every event posted before the call has been applied and publishes a fresh snapshot.
+        */
+        void Sync();
+
+        /**
+         * Never blocks writers. Throws std::out_of_range for a bad core number.
+        */
+        int GetCPU( int core = 0 ) const;
+
+        /**
+         * Latest published snapshot. Asking for it makes the sequencer publish a newer one after its next batch.
+        */
+        std::shared_ptr<const SimSnapshot> Snapshot();
+
+        std::deque<int> GetReadyQueue( int core = 0 );
+        MemoryUsage GetMemory();
+        FileReadRequest GetDisk( int diskNumber );
+        std::deque<FileReadRequest> GetDiskQueue( int diskNumber );
+
+        std::uint64_t Rejected() const { return rejected_.load(std::memory_order_relaxed); }
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "eventSimulator.h"
+
+#include <stdexcept>
+
+EventSimulator::EventSimulator( int numberOfDisks, unsigned long long amountOfRAM, unsigned int pageSize,
+    const SimOptions& options, const ClockConfig& clock )
+:sim_(numberOfDisks, amountOfRAM, pageSize, options),clock_{clock},file_{sim_.InternFileName("data")},
+cores_(sim_.NumberOfCores()),diskGenerations_(sim_.NumberOfDisks()),heads_(sim_.NumberOfDisks())
+{
+    stats_.coreBusy.resize(sim_.NumberOfCores());
+    stats_.diskBusy.resize(sim_.NumberOfDisks());
+    sim_.SetListener(this);
+}
+
+void EventSimulator::Inject( const Job& job )
+{
+    if (job.arrival < now_ || job.bursts.empty())
+    {
+        throw std::invalid_argument("Job arrives in the past or has no CPU burst\n");
+    }
+    for (std::size_t burst = 0; burst + 1 < job.bursts.size(); ++burst)
+    {
+        if (job.bursts[burst].disk < 0 || job.bursts[burst].disk >= sim_.NumberOfDisks())
+        {
+            throw std::invalid_argument("Job reads from a disk that doesn't exist\n");
+        }
+    }
+    wheel_.Schedule(TimedEvent{job.arrival, jobs_.size(), 0, Arrival});
+    jobs_.push_back(job);
+}
+
+void EventSimulator::Inject( const std::vector<Job>& jobs )
+{
+    jobs_.reserve(jobs_.size() + jobs.size());
+    for (const Job& job : jobs)
+        Inject(job);
+}
+
+unsigned long long EventSimulator::RunUntil( unsigned long long time )
+{
+    unsigned long long fired = Advance(time);
+    now_ = std::max(now_, time);
+    return fired;
+}
+
+unsigned long long EventSimulator::Run()
+{
+    return Advance(~0ULL);
+}
+
+unsigned long long EventSimulator::Advance(unsigned long long limit)
+{
+    unsigned long long fired = 0;
+    TimedEvent event;
+    while (wheel_.PopNext(limit, event))
+    {
+        now_ = event.time;
+        ++fired;
+        switch (event.kind)
+        {
+            case Arrival:
+                Arrive(event.tag);
+                break;
+            case CoreDone:
+                if (event.tag == cores_[event.unit].generation && sim_.GetCPU(event.unit) == cores_[event.unit].PID)
+                    EndOfSlice(event.unit);
+                break;
+            case DiskDone:
+                if (event.tag == diskGenerations_[event.unit])
+                    sim_.DiskJobCompleted(event.unit);
+                break;
+        }
+    }
+    stats_.events += fired;
+    return fired;
+}
+
+void EventSimulator::Arrive(std::size_t job)
+{
+    // Registered before NewProcess, which may already dispatch the job
+    int pid = sim_.NextPID();
+    running_.emplace(pid, JobState{job, 0, jobs_[job].bursts.front().cpuTime, false, JobStats{pid, now_}});
+    sim_.NewProcess();
+}
+
+void EventSimulator::Dispatched(int core, int pid)
+{
+    auto found = running_.find(pid);
+    if (found == running_.end())
+        return;
+    JobState& state = found->second;
+    if (!state.started)
+    {
+        state.started = true;
+        state.stats.firstRun = now_;
+    }
+    Running& run = cores_[core];
+    run.since = now_;
+    run.PID = pid;
+    ++run.generation;
+    unsigned long long slice = clock_.quantum == 0 ? state.remaining : std::min(clock_.quantum, state.remaining);
+    wheel_.Schedule(TimedEvent{now_ + slice, run.generation, core, CoreDone});
+}
+
+void EventSimulator::DiskStarted(int diskNumber, const DiskRequest& request)
+{
+    unsigned long long& head = heads_[diskNumber];
+    unsigned long long seek = request.block > head ? request.block - head : head - request.block;
+    head = request.block + request.size;
+    unsigned long long service = clock_.diskLatency + request.size * clock_.blockTime + seek * clock_.seekTime;
+    stats_.diskBusy[diskNumber] += service;
+    auto found = running_.find(request.PID);
+    if (found != running_.end())
+        found->second.stats.diskTime += service;
+    wheel_.Schedule(TimedEvent{now_ + service, ++diskGenerations_[diskNumber], diskNumber, DiskDone});
+}
+
+void EventSimulator::EndOfSlice(int core)
+{
+    Running& run = cores_[core];
+    auto found = running_.find(run.PID);
+    if (found == running_.end())
+        return;
+    JobState& state = found->second;
+    unsigned long long elapsed = now_ - run.since;
+    stats_.coreBusy[core] += elapsed;
+    state.stats.cpuTime += elapsed;
+    state.remaining -= std::min(elapsed, state.remaining);
+    if (state.remaining != 0)
+    {
+        sim_.TimerInterrupt(core);
+        return;
+    }
+
+    const Job& job = jobs_[state.job];
+    const Burst& burst = job.bursts[state.burst];
+    if (++state.burst == job.bursts.size())
+    {
+        JobStats& stats = finished_.emplace_back(state.stats);
+        stats.finish = now_;
+        stats_.turnaround.Add(stats.Turnaround());
+        stats_.response.Add(stats.Response());
+        stats_.wait.Add(stats.Wait());
+        running_.erase(found);
+        sim_.SimExit(core);
+    }
+    else
+    {
+        state.remaining = job.bursts[state.burst].cpuTime;
+        sim_.DiskReadRequest(burst.disk, file_, burst.block, burst.blocks, core);
+    }
+}
+
+double EventSimulator::CoreUtilization( int core ) const
+{
+    return now_ == 0 ? 0.0 : static_cast<double>(stats_.coreBusy.at(core)) / now_;
+}
+
+double EventSimulator::DiskUtilization( int diskNumber ) const
+{
+    return now_ == 0 ? 0.0 : static_cast<double>(stats_.diskBusy.at(diskNumber)) / now_;
+}
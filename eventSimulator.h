@@ -0,0 +1,148 @@
+#ifndef EVENT_SIMULATOR_H
+#define EVENT_SIMULATOR_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "simOS.h"
+#include "timingWheel.h"
+#include "workload.h"
+
+/**
+ * Service times in ticks. A process is preempted after quantum ticks on a core, 0 lets it run to the end of
+ * its burst. A disk request takes diskLatency plus blockTime per block read plus seekTime per block the head
+ * moves, like DiskStats::totalSeekDistance counts them.
+ */
+struct ClockConfig
+{
+    unsigned long long quantum {10};
+    unsigned long long diskLatency {4};
+    unsigned long long blockTime {1};
+    unsigned long long seekTime {0};
+};
+
+/**
+ * Life of one job. Turnaround runs from arrival to exit, response from arrival to the first dispatch.
+ * diskTime is the service time of its reads, so Wait() is everything spent in the ready and disk queues.
+ */
+struct JobStats
+{
+    int PID {0};
+    unsigned long long arrival {0};
+    unsigned long long firstRun {0};
+    unsigned long long finish {0};
+    unsigned long long cpuTime {0};
+    unsigned long long diskTime {0};
+
+    unsigned long long Turnaround() const { return finish - arrival; }
+    unsigned long long Response() const { return firstRun - arrival; }
+    unsigned long long Wait() const { return Turnaround() - cpuTime - diskTime; }
+};
+
+/**
+ * Distributions over the finished jobs and how busy every core and disk was.
+ */
+struct ClockStats
+{
+    unsigned long long events {0};
+    Log2Histogram turnaround;
+    Log2Histogram response;
+    Log2Histogram wait;
+    std::vector<unsigned long long> coreBusy;   // ticks each core ran a process
+    std::vector<unsigned long long> diskBusy;   // ticks each disk served requests
+};
+
+/**
+ * Discrete event driver of a SimOS on a simulated clock. Jobs arrive at their arrival time as new processes.
+ * Whenever a core dispatches a process, the end of its quantum or of its CPU burst, whichever comes first,
+ * is put on a timing wheel, and so is the completion of every disk request the SimOS starts. Firing an event
+ * makes the matching SimOS call: TimerInterrupt at the end of a quantum, DiskReadRequest or SimExit at the
+ * end of a burst and DiskJobCompleted when a disk is done. SimOS reports dispatches and disk starts through
+ * SimListener, so nothing is polled between events. An event whose process left the core or whose request
+ * finished in the meantime is dropped when it fires.
+ *
+ * The SimOS is driven by the simulator alone, PIDs are assigned to the jobs in order of arrival.
+ */
+class EventSimulator : private SimListener
+{
+    private:
+        enum EventKind : unsigned char { Arrival, CoreDone, DiskDone };
+
+        struct Running
+        {
+            unsigned long long since {0};
+            unsigned long long generation {0};
+            int PID {NO_PROCESS};
+        };
+
+        struct JobState
+        {
+            std::size_t job;
+            std::size_t burst;
+            unsigned long long remaining;   // CPU time left in the current burst
+            bool started;
+            JobStats stats;
+        };
+
+        SimOS sim_;
+        ClockConfig clock_;
+        TimingWheel wheel_;
+        unsigned long long now_ {0};
+        std::vector<Job> jobs_;
+        std::unordered_map<int, JobState> running_;   // jobs that arrived and didn't exit yet
+        FileId file_;
+        std::vector<Running> cores_;
+        std::vector<unsigned long long> diskGenerations_;
+        std::vector<unsigned long long> heads_;
+        std::vector<JobStats> finished_;
+        ClockStats stats_;
+
+        void Dispatched(int core, int pid) override;
+        void DiskStarted(int diskNumber, const DiskRequest& request) override;
+
+        unsigned long long Advance(unsigned long long limit);
+        void Arrive(std::size_t job);
+        void EndOfSlice(int core);
+
+    public:
+        EventSimulator( int numberOfDisks, unsigned long long amountOfRAM, unsigned int pageSize,
+            const SimOptions& options = SimOptions(), const ClockConfig& clock = ClockConfig() );
+
+        EventSimulator(const EventSimulator&) = delete;
+        EventSimulator& operator=(const EventSimulator&) = delete;
+
+        /**
+         * Adds a job. Throws std::invalid_argument if it arrives before Now(), has no bursts or reads
+         * from a disk that doesn't exist.
+        */
+        void Inject( const Job& job );
+        void Inject( const std::vector<Job>& jobs );
+
+        /**
+         * Fires every event due up to and including time, then sets the clock to time.
+         * Returns the number of events fired.
+        */
+        unsigned long long RunUntil( unsigned long long time );
+
+        /**
+         * Fires events until there are none left, i.e. every injected job finished.
+        */
+        unsigned long long Run();
+
+        unsigned long long Now() const { return now_; }
+        const SimOS& Sim() const { return sim_; }
+        const ClockStats& Stats() const { return stats_; }
+
+        /**
+         * Share of the time so far a core ran a process or a disk was serving a request.
+        */
+        double CoreUtilization( int core ) const;
+        double DiskUtilization( int diskNumber ) const;
+
+        /**
+         * Finished jobs in the order they exited.
+        */
+        const std::vector<JobStats>& Finished() const { return finished_; }
+};
+
+#endif
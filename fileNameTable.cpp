@@ -0,0 +1,46 @@
+#include "fileNameTable.h"
+
+FileNameTable::FileNameTable()
+{
+    names_.emplace_back();
+    ids_.emplace(names_.back(), NO_FILE);
+}
+
+FileId FileNameTable::Intern(std::string_view name)
+{
+    auto found = ids_.find(name);
+    if (found != ids_.end())
+        return found->second;
+    return Intern(std::string(name));
+}
+
+FileId FileNameTable::Intern(std::string&& name)
+{
+    auto found = ids_.find(name);
+    if (found != ids_.end())
+        return found->second;
+    FileId id = static_cast<FileId>(names_.size());
+    names_.push_back(std::move(name));
+    ids_.emplace(names_.back(), id);
+    return id;
+}
+
+void FileNameTable::Save(CheckpointWriter& out) const
+{
+    out.Write<std::uint64_t>(names_.size());
+    for (const auto& name : names_)
+        out.WriteString(name);
+}
+
+void FileNameTable::Load(CheckpointReader& in)
+{
+    std::uint64_t count = in.Read<std::uint64_t>();
+    ids_.clear();
+    names_.clear();
+    for (std::uint64_t id = 0; id < count; ++id)
+    {
+        names_.push_back(in.ReadString());
+        CheckCheckpoint(id <= UINT32_MAX && ids_.emplace(names_.back(), static_cast<FileId>(id)).second);
+    }
+    CheckCheckpoint(!names_.empty() && names_[NO_FILE].empty());
+}
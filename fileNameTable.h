@@ -0,0 +1,59 @@
+#ifndef FILE_NAME_TABLE_H
+#define FILE_NAME_TABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "checkpoint.h"
+
+using FileId = std::uint32_t;
+
+constexpr FileId NO_FILE{ 0 };   // id of the empty file name
+
+/**
+ * Interning table for the file names of disk reads. Every distinct name is stored once and requests
+ * refer to it by a small id, so queuing and serving a read never copies or allocates a string.
+ * Names are never dropped, the table grows with the number of distinct names seen over the run.
+ */
+class FileNameTable
+{
+    private:
+        std::deque<std::string> names_;   // deque keeps the strings (and the views into them) in place
+        std::unordered_map<std::string_view, FileId> ids_;
+
+    public:
+        FileNameTable();
+
+        // The keys of ids_ view the strings of names_, a copy would point into the table it was copied from.
+        // Moving hands over the deque's blocks, so the strings and the views stay where they are.
+        FileNameTable(const FileNameTable&) = delete;
+        FileNameTable& operator=(const FileNameTable&) = delete;
+        FileNameTable(FileNameTable&&) = default;
+        FileNameTable& operator=(FileNameTable&&) = default;
+
+        /**
+         * Returns the id of the name, adding it if it is new. The rvalue overload moves a new name into the table.
+        */
+        FileId Intern(std::string_view name);
+        FileId Intern(std::string&& name);
+        FileId Intern(const char* name) { return Intern(std::string_view(name)); }
+
+        /**
+         * Name of an id returned by Intern. Throws std::out_of_range for an unknown id.
+        */
+        const std::string& Name(FileId id) const { return names_.at(id); }
+
+        std::size_t size() const { return names_.size(); }
+
+        /**
+         * Writes or restores every name, ids stay the same. Load throws std::runtime_error for a repeated name
+         * or a table that doesn't start with the empty name.
+        */
+        void Save(CheckpointWriter& out) const;
+        void Load(CheckpointReader& in);
+};
+
+#endif
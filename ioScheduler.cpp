@@ -0,0 +1,197 @@
+#include "ioScheduler.h"
+
+#include <iterator>
+#include <limits>
+
+std::unique_ptr<IoScheduler> IoScheduler::Create(DiskPolicy policy, ProcessTable& processes)
+{
+    switch (policy)
+    {
+        case DiskPolicy::SSTF:     return std::make_unique<SSTFDiskScheduler>(processes);
+        case DiskPolicy::Elevator: return std::make_unique<ElevatorDiskScheduler>(processes);
+        case DiskPolicy::CLook:    return std::make_unique<CLookDiskScheduler>(processes);
+        case DiskPolicy::Deadline: return std::make_unique<DeadlineDiskScheduler>(processes);
+        case DiskPolicy::FIFO: break;
+    }
+    return std::make_unique<FIFODiskScheduler>(processes);
+}
+
+void FIFODiskScheduler::Enqueue(Process& process)
+{
+    queue_.PushBack(processes_, process.PID);
+}
+
+int FIFODiskScheduler::Dequeue(unsigned long long head, unsigned long long served)
+{
+    return queue_.PopFront(processes_);
+}
+
+void FIFODiskScheduler::Remove(Process& process)
+{
+    queue_.Remove(processes_, process.PID);
+}
+
+void FIFODiskScheduler::ForEach(const std::function<void(int)>& visit) const
+{
+    queue_.ForEach(processes_, [&visit](const Process& process) {
+        visit(process.PID);
+    });
+}
+
+void OrderedDiskScheduler::Enqueue(Process& process)
+{
+    process.ioSeq = arrivals_++;
+    byBlock_.emplace(Key{process.ioBlock, process.ioSeq}, process.PID);
+    byArrival_.emplace(process.ioSeq, process.PID);
+}
+
+int OrderedDiskScheduler::Take(std::set<std::pair<Key, int>>::iterator entry)
+{
+    int pid = entry->second;
+    byArrival_.erase(std::make_pair(entry->first.second, pid));
+    byBlock_.erase(entry);
+    return pid;
+}
+
+std::set<std::pair<OrderedDiskScheduler::Key, int>>::iterator OrderedDiskScheduler::NextUp(unsigned long long head)
+{
+    auto next = byBlock_.lower_bound(std::make_pair(Key{head, 0}, NO_PROCESS));
+    return next != byBlock_.end() ? next : byBlock_.begin();
+}
+
+void OrderedDiskScheduler::Remove(Process& process)
+{
+    if (byBlock_.erase(std::make_pair(Key{process.ioBlock, process.ioSeq}, process.PID)) != 0)
+        byArrival_.erase(std::make_pair(process.ioSeq, process.PID));
+}
+
+void OrderedDiskScheduler::ForEach(const std::function<void(int)>& visit) const
+{
+    for (const auto& entry : byArrival_)
+        visit(entry.second);
+}
+
+int SSTFDiskScheduler::Dequeue(unsigned long long head, unsigned long long served)
+{
+    if (byBlock_.empty())
+        return NO_PROCESS;
+    auto above = byBlock_.lower_bound(std::make_pair(Key{head, 0}, NO_PROCESS));
+    if (above == byBlock_.begin())
+        return Take(above);
+    auto below = std::prev(above);
+    if (above == byBlock_.end() || head - below->first.first <= above->first.first - head)
+        return Take(below);
+    return Take(above);
+}
+
+int ElevatorDiskScheduler::Dequeue(unsigned long long head, unsigned long long served)
+{
+    if (byBlock_.empty())
+        return NO_PROCESS;
+    auto above = byBlock_.lower_bound(std::make_pair(Key{head, 0}, NO_PROCESS));
+    if (movingUp_ && above == byBlock_.end())
+        movingUp_ = false;
+    else if (!movingUp_ && byBlock_.begin()->first.first > head)
+        movingUp_ = true;
+
+    if (movingUp_)
+        return Take(above);
+
+    // Highest block at or below the head, oldest request first among equal blocks
+    auto below = std::prev(byBlock_.upper_bound(std::make_pair(Key{head, std::numeric_limits<unsigned long long>::max()}, NO_PROCESS)));
+    return Take(byBlock_.lower_bound(std::make_pair(Key{below->first.first, 0}, NO_PROCESS)));
+}
+
+int CLookDiskScheduler::Dequeue(unsigned long long head, unsigned long long served)
+{
+    if (byBlock_.empty())
+        return NO_PROCESS;
+    return Take(NextUp(head));
+}
+
+int DeadlineDiskScheduler::Dequeue(unsigned long long head, unsigned long long served)
+{
+    if (byBlock_.empty())
+        return NO_PROCESS;
+    if (batchLeft_ > 0)
+    {
+        --batchLeft_;
+        return Take(NextUp(head));
+    }
+    const Process& oldest = *processes_.Find(byArrival_.begin()->second);
+    if (served - oldest.ioQueuedAt >= DEADLINE)
+    {
+        batchLeft_ = BATCH;
+        return Take(byBlock_.find(std::make_pair(Key{oldest.ioBlock, oldest.ioSeq}, oldest.PID)));
+    }
+    return Take(NextUp(head));
+}
+
+void FIFODiskScheduler::Save(CheckpointWriter& out) const
+{
+    std::vector<int> pids;
+    ForEach([&pids](int pid) {
+        pids.push_back(pid);
+    });
+    out.WriteVector(pids);
+}
+
+void FIFODiskScheduler::Load(CheckpointReader& in)
+{
+    std::vector<int> pids;
+    in.ReadVector(pids);
+    queue_.Reset();
+    for (int pid : pids)
+        queue_.PushBack(processes_, processes_.Queued(pid).PID);
+}
+
+void OrderedDiskScheduler::Save(CheckpointWriter& out) const
+{
+    std::vector<int> pids;
+    ForEach([&pids](int pid) {
+        pids.push_back(pid);
+    });
+    out.Write(arrivals_);
+    out.WriteVector(pids);
+}
+
+void OrderedDiskScheduler::Load(CheckpointReader& in)
+{
+    arrivals_ = in.Read<unsigned long long>();
+    std::vector<int> pids;
+    in.ReadVector(pids);
+    byBlock_.clear();
+    byArrival_.clear();
+    for (int pid : pids)
+    {
+        const Process& process = processes_.Queued(pid);
+        byArrival_.emplace_hint(byArrival_.end(), process.ioSeq, pid);
+        byBlock_.emplace(Key{process.ioBlock, process.ioSeq}, pid);
+    }
+    CheckCheckpoint(byArrival_.size() == pids.size() && byBlock_.size() == pids.size());
+}
+
+void ElevatorDiskScheduler::Save(CheckpointWriter& out) const
+{
+    OrderedDiskScheduler::Save(out);
+    out.Write(movingUp_);
+}
+
+void ElevatorDiskScheduler::Load(CheckpointReader& in)
+{
+    OrderedDiskScheduler::Load(in);
+    movingUp_ = in.ReadBool();
+}
+
+void DeadlineDiskScheduler::Save(CheckpointWriter& out) const
+{
+    OrderedDiskScheduler::Save(out);
+    out.Write(batchLeft_);
+}
+
+void DeadlineDiskScheduler::Load(CheckpointReader& in)
+{
+    OrderedDiskScheduler::Load(in);
+    batchLeft_ = in.Read<unsigned long long>();
+    CheckCheckpoint(batchLeft_ <= BATCH);
+}
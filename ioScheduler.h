@@ -0,0 +1,160 @@
+#ifndef IO_SCHEDULER_H
+#define IO_SCHEDULER_H
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <utility>
+
+#include "processTable.h"
+#include "checkpoint.h"
+
+/**
+ * Order in which a disk serves its queued read requests.
+ * FIFO:     arrival order (the original SimOS behaviour).
+ * SSTF:     shortest seek first, the request closest to the current head position.
+ * Elevator: SCAN/LOOK, keeps moving the head in one direction and turns around at the last request.
+ * CLook:    like Elevator but only serves upwards, then jumps back to the lowest request.
+ * Deadline: CLook order, except a request that waited DEADLINE dispatches or more is served right away,
+ *           followed by a batch in CLook order from there so a saturated disk doesn't fall back to FIFO.
+ */
+enum class DiskPolicy
+{
+    FIFO,
+    SSTF,
+    Elevator,
+    CLook,
+    Deadline
+};
+
+/**
+ * Queue of read requests waiting for one disk. The request itself (block, size, file) lives in the
+ * waiting Process, the queue only orders PIDs. All policies pick the next request in O(log n) or better.
+ */
+class IoScheduler
+{
+    protected:
+        ProcessTable& processes_;
+
+    public:
+        explicit IoScheduler(ProcessTable& processes) : processes_(processes) {}
+        virtual ~IoScheduler() = default;
+
+        virtual void Enqueue(Process& process) = 0;
+
+        /**
+         * Removes and returns the request to serve next given the head position and the number of
+         * requests the disk served so far, or NO_PROCESS if the queue is empty.
+        */
+        virtual int Dequeue(unsigned long long head, unsigned long long served) = 0;
+
+        virtual void Remove(Process& process) = 0;
+        virtual std::size_t size() const = 0;
+        bool empty() const { return size() == 0; }
+
+        /**
+         * Calls visit(pid) in arrival order.
+        */
+        virtual void ForEach(const std::function<void(int)>& visit) const = 0;
+
+        /**
+         * Writes or restores the queue for a checkpoint, after the process table (see Scheduler::Save).
+        */
+        virtual void Save(CheckpointWriter& out) const = 0;
+        virtual void Load(CheckpointReader& in) = 0;
+
+        static std::unique_ptr<IoScheduler> Create(DiskPolicy policy, ProcessTable& processes);
+};
+
+class FIFODiskScheduler : public IoScheduler
+{
+    private:
+        PidQueue queue_;
+
+    public:
+        using IoScheduler::IoScheduler;
+
+        void Enqueue(Process& process) override;
+        int Dequeue(unsigned long long head, unsigned long long served) override;
+        void Remove(Process& process) override;
+        std::size_t size() const override { return queue_.size(); }
+        void ForEach(const std::function<void(int)>& visit) const override;
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+/**
+ * Shared base of the seek ordered policies: requests indexed by (block, arrival) plus an arrival ordered index.
+ */
+class OrderedDiskScheduler : public IoScheduler
+{
+    protected:
+        using Key = std::pair<unsigned long long, unsigned long long>;
+
+        std::set<std::pair<Key, int>> byBlock_;
+        std::set<std::pair<unsigned long long, int>> byArrival_;
+        unsigned long long arrivals_ {0};
+
+        /**
+         * Unlinks the entry from both indices and returns its PID.
+        */
+        int Take(std::set<std::pair<Key, int>>::iterator entry);
+
+        /**
+         * First request at or above the head, wrapping around to the lowest block.
+        */
+        std::set<std::pair<Key, int>>::iterator NextUp(unsigned long long head);
+
+    public:
+        using IoScheduler::IoScheduler;
+
+        void Enqueue(Process& process) override;
+        void Remove(Process& process) override;
+        std::size_t size() const override { return byBlock_.size(); }
+        void ForEach(const std::function<void(int)>& visit) const override;
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+class SSTFDiskScheduler : public OrderedDiskScheduler
+{
+    public:
+        using OrderedDiskScheduler::OrderedDiskScheduler;
+        int Dequeue(unsigned long long head, unsigned long long served) override;
+};
+
+class ElevatorDiskScheduler : public OrderedDiskScheduler
+{
+    private:
+        bool movingUp_ {true};
+
+    public:
+        using OrderedDiskScheduler::OrderedDiskScheduler;
+        int Dequeue(unsigned long long head, unsigned long long served) override;
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+class CLookDiskScheduler : public OrderedDiskScheduler
+{
+    public:
+        using OrderedDiskScheduler::OrderedDiskScheduler;
+        int Dequeue(unsigned long long head, unsigned long long served) override;
+};
+
+class DeadlineDiskScheduler : public OrderedDiskScheduler
+{
+    private:
+        static constexpr unsigned long long DEADLINE = 64;
+        static constexpr unsigned long long BATCH = 16;   // requests served in block order after an expired one
+
+        unsigned long long batchLeft_ {0};
+
+    public:
+        using OrderedDiskScheduler::OrderedDiskScheduler;
+        int Dequeue(unsigned long long head, unsigned long long served) override;
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+#endif
@@ -2,7 +2,15 @@
 
 
 
-#include "SimOS.h"
+#include "simOS.h"
+#include "concurrentSimOS.h"
+#include "eventSimulator.h"
+#include "traceReplay.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
 //#include "Process.h"
 //#include "Drive.h"
 //#include "RAM.h"
@@ -192,5 +200,536 @@ int main() {
 		passed = false;
 	}
 
+	sim.SimFork();		//19
+	sim.TimerInterrupt();	//CPU 19 | Q: 18
+	sim.AccessMemoryAddress(0);
+	sim.SimExit();		//19 turns to zombie and releases its frame right away
+	sim.SimWait();		//18 reaps the zombie
+	ram = sim.GetMemory();
+	if (sim.GetCPU() != 18 || ram.size() != 1 || ram[0].PID != 18) {
+		std::cout<<"Failed to release memory of a zombie process (line 209)\n";
+		passed = false;
+	}
+
+	//TESTING MULTI-CORE
+	SimOS multi(1,10,1,2);
+	multi.NewProcess();	//1 on core 0
+	multi.NewProcess();	//2 on core 1
+	multi.NewProcess();	//3 queued on core 0
+	if (multi.GetCPU(0) != 1 || multi.GetCPU(1) != 2 || multi.GetReadyQueue(0).size() != 1) {
+		std::cout<<"Failed to spread new processes over cores (line 219)\n";
+		passed = false;
+	}
+
+	multi.SimExit(1);	//core 1 steals 3 from core 0
+	if (multi.GetCPU(1) != 3 || multi.GetReadyQueue(0).size() != 0) {
+		std::cout<<"Failed to steal work for an idle core (line 225)\n";
+		passed = false;
+	}
+
+	//TESTING SCHEDULING POLICIES
+	SimOptions priorityOptions;
+	priorityOptions.scheduling = SchedulingPolicy::Priority;
+	SimOS prioritySim(1,10,1,priorityOptions);
+	prioritySim.NewProcess();	//1
+	prioritySim.NewProcess();	//2
+	prioritySim.NewProcess();	//3
+	prioritySim.SetPriority(3, -1);
+	prioritySim.TimerInterrupt();	//CPU: 3 | Q: 2, 1
+	if (prioritySim.GetCPU() != 3 || prioritySim.GetReadyQueue().front() != 2) {
+		std::cout<<"Failed to run the highest priority process first (line 239)\n";
+		passed = false;
+	}
+
+	//TESTING DISK SCHEDULING
+	SimOptions diskOptions;
+	diskOptions.diskScheduling = DiskPolicy::SSTF;
+	SimOS diskSim(1,10,1,diskOptions);
+	diskSim.NewProcess();	//1
+	diskSim.NewProcess();	//2
+	diskSim.NewProcess();	//3
+	diskSim.DiskReadRequest(0, "a.txt", 50, 10);	//Disk: 1, head ends at 60
+	diskSim.DiskReadRequest(0, "b.txt", 100, 1);
+	diskSim.DiskReadRequest(0, "c.txt", 55, 1);
+	diskSim.DiskJobCompleted(0);	//Disk: 3 is closer to the head than 2
+	if (diskSim.GetDisk(0).PID != 3 || diskSim.GetDiskQueue(0).front().PID != 2 || diskSim.GetDiskStats(0).totalSeekDistance != 55) {
+		std::cout<<"Failed to serve the closest disk request first (line 255)\n";
+		passed = false;
+	}
+
+	FileId shrek = diskSim.InternFileName("Shrek.mov");
+	diskSim.DiskJobCompleted(0);	//CPU: 1 | Disk: 2
+	diskSim.DiskReadRequest(0, shrek);
+	if (diskSim.InternFileName("Shrek.mov") != shrek || diskSim.GetDiskQueue(0).front().fileName != "Shrek.mov") {
+		std::cout<<"Failed to read a file by its interned name (line 263)\n";
+		passed = false;
+	}
+
+	SimOptions deadlineOptions;
+	deadlineOptions.diskScheduling = DiskPolicy::Deadline;
+	SimOS deadlineSim(1,10,1,deadlineOptions);
+	SimOS fifoDiskSim(1,10,1);
+	for (int pid = 1; pid <= 100; ++pid) {
+		deadlineSim.NewProcess();
+		fifoDiskSim.NewProcess();
+	}
+	for (int request = 0; request < 100; ++request) {
+		deadlineSim.DiskReadRequest(0, "a.txt", request * 37 % 100 * 10, 1);	//100 requests queued, scattered blocks
+		fifoDiskSim.DiskReadRequest(0, "a.txt", request * 37 % 100 * 10, 1);
+	}
+	while (deadlineSim.GetDisk(0).PID != NO_PROCESS) deadlineSim.DiskJobCompleted(0);
+	while (fifoDiskSim.GetDisk(0).PID != NO_PROCESS) fifoDiskSim.DiskJobCompleted(0);
+	if (deadlineSim.GetDiskStats(0).totalSeekDistance * 10 > fifoDiskSim.GetDiskStats(0).totalSeekDistance) {
+		std::cout<<"Failed to keep a deep Deadline disk queue in block order (line 282)\n";
+		passed = false;
+	}
+
+	//TESTING DEEP CASCADING TERMINATION
+	SimOS chainSim(1,10,1,priorityOptions);
+	chainSim.NewProcess();	//1
+	for (int depth = 1; depth <= 200000; ++depth) {
+		chainSim.SimFork();	//every child forks the next one
+		chainSim.SetPriority(depth + 1, -depth);
+		chainSim.TimerInterrupt();
+	}
+	chainSim.SetPriority(1, -300000);
+	chainSim.TimerInterrupt();	//CPU: 1
+	chainSim.SimExit();
+	if (chainSim.GetCPU() != NO_PROCESS || chainSim.ReadyQueueSize() != 0) {
+		std::cout<<"Failed to terminate a deep chain of descendants (line 298)\n";
+		passed = false;
+	}
+
+	//TESTING CONCURRENT FRONT END
+	ConcurrentSimOS shared(1,10,1);
+	bool rethrown = false;
+	try {
+		shared.SimFork();
+	}
+	catch (const std::logic_error&) {
+		rethrown = true;
+	}
+	std::thread producer([&shared]() {
+		for (int i = 0; i < 100; ++i) shared.NewProcess();
+	});
+	for (int i = 0; i < 100; ++i) shared.Post(SimEvent{TraceOp::NewProcess});
+	producer.join();
+	shared.Sync();
+	if (!rethrown || shared.GetCPU() != 1 || shared.GetReadyQueue().size() != 199 || shared.Rejected() != 0) {
+		std::cout<<"Failed to apply events from several threads (line 318)\n";
+		passed = false;
+	}
+
+	//TESTING CHECKPOINT AND RESTORE
+	SimOS saved(1,10,1,priorityOptions);
+	saved.NewProcess();	//1
+	saved.SimFork();	//2
+	saved.AccessMemoryAddress(3);
+	saved.DiskReadRequest(0, "Shrek.mov");	//CPU: 2 | Disk: 1
+	std::vector<unsigned char> image = saved.Checkpoint();
+	SimOS restored(2,100,4);
+	restored.RestoreCheckpoint(image.data(), image.size());
+	restored.DiskJobCompleted(0);
+	saved.DiskJobCompleted(0);
+	bool restoredSame = restored.GetCPU() == saved.GetCPU() && restored.GetReadyQueue() == saved.GetReadyQueue()
+		&& restored.GetMemory().size() == 1 && restored.GetDisk(0).fileName == "";
+	bool truncated = false;
+	try {
+		restored.RestoreCheckpoint(image.data(), image.size() - 1);
+	}
+	catch (const std::runtime_error&) {
+		truncated = true;
+	}
+	if (!restoredSame || !truncated) {
+		std::cout<<"Failed to restore a checkpoint (line 343)\n";
+		passed = false;
+	}
+	bool damagedRefused = true;
+	int resealedRefused = 0;
+	for (std::size_t at = CHECKPOINT_HEADER_SIZE; at < image.size(); ++at) {
+		std::vector<unsigned char> damaged = image;
+		damaged[at] ^= 0xFF;
+		try {
+			restored.RestoreCheckpoint(damaged.data(), damaged.size());
+			damagedRefused = false;
+		}
+		catch (const std::runtime_error&) {}
+		std::uint64_t sum = CheckpointChecksum(damaged.data() + CHECKPOINT_HEADER_SIZE, damaged.size() - CHECKPOINT_HEADER_SIZE);
+		std::memcpy(damaged.data() + CHECKPOINT_HEADER_SIZE - sizeof(sum), &sum, sizeof(sum));
+		try {
+			restored.RestoreCheckpoint(damaged.data(), damaged.size());
+		}
+		catch (const std::runtime_error&) {
+			++resealedRefused;
+		}
+	}
+	if (!damagedRefused || resealedRefused == 0) {
+		std::cout<<"Failed to refuse a damaged checkpoint (line 366)\n";
+		passed = false;
+	}
+
+	//TESTING REPLACEMENT ALGORITHMS
+	SimOptions fifoOptions;
+	fifoOptions.replacement = ReplacementAlgorithm::FIFO;
+	SimOS lruSim(1,3,1);
+	SimOS fifoSim(1,3,1,fifoOptions);
+	for (SimOS* sim : {&lruSim, &fifoSim}) {
+		sim->NewProcess();
+		for (unsigned long long address : {1, 2, 3, 1, 4}) sim->AccessMemoryAddress(address);
+	}
+	//LRU replaces page 2, FIFO page 1
+	if (lruSim.GetMemory()[1].pageNumber != 4 || fifoSim.GetMemory()[0].pageNumber != 4
+		|| fifoSim.GetMemoryStats().faults != 4 || fifoSim.GetMemoryStats().evictions != 1) {
+		std::cout<<"Failed to replace pages by the chosen algorithm (line 381)\n";
+		passed = false;
+	}
+
+	//TESTING HUGE PAGES
+	SimOptions hugeOptions;
+	hugeOptions.hugePageSize = 8;
+	hugeOptions.hugePages = HugePageMode::Advised;
+	SimOS hugeSim(1,64,1,hugeOptions);
+	hugeSim.NewProcess();
+	hugeSim.AdviseHugePages(12, 20);	//huge pages 2 and 3
+	hugeSim.AccessMemoryAddress(17);	//frames 0-7 hold pages 16-23
+	hugeSim.AccessMemoryAddress(23);
+	hugeSim.AccessMemoryAddress(40);	//frame 8, not advised
+	if (hugeSim.GetMemory().size() != 9 || hugeSim.GetMemory()[0].pageNumber != 16 || hugeSim.GetMemory()[8].pageNumber != 40
+		|| hugeSim.GetMemoryStats().faults != 2 || hugeSim.GetMemoryStats().hugeFaults != 1) {
+		std::cout<<"Failed to load a huge page (line 397)\n";
+		passed = false;
+	}
+
+	SimOptions tlbOptions;
+	tlbOptions.tlb.sets = 1;
+	tlbOptions.tlb.ways = 2;
+	tlbOptions.tlb.tagged = false;
+	SimOS tlbSim(1,40,10,tlbOptions);
+	tlbSim.NewProcess();
+	tlbSim.AccessMemoryAddress(5);		//miss
+	tlbSim.AccessMemoryAddress(7);		//hit
+	tlbSim.NewProcess();
+	tlbSim.TimerInterrupt();			//flushed on the switch to PID 2
+	tlbSim.AccessMemoryAddress(5);		//miss
+	if (tlbSim.GetTLBStats().hits != 1 || tlbSim.GetTLBStats().misses != 2 || tlbSim.GetTLBStats().flushes != 1) {
+		std::cout<<"Failed to flush an untagged TLB on a context switch (line 414)\n";
+		passed = false;
+	}
+
+	SimOptions cowOptions;
+	cowOptions.copyOnWrite = true;
+	SimOS cowSim(1,100,10,cowOptions);
+	cowSim.NewProcess();
+	cowSim.AccessMemoryAddress(5);		//frame 0
+	cowSim.AccessMemoryAddress(15);		//frame 1
+	cowSim.SimFork();					//PID 2 shares both frames
+	cowSim.WriteMemoryAddress(15);		//PID 1 copies page 1 into frame 2
+	if (cowSim.GetMemory().size() != 3 || cowSim.GetMemory()[0].references != 2 || cowSim.GetMemory()[1].PID != 2
+		|| cowSim.GetMemory()[2].PID != 1 || cowSim.GetResidentMemory(1).sharedFrames != 1 || cowSim.GetMemoryStats().copyOnWrites != 1) {
+		std::cout<<"Failed to copy a shared page on write (line 427)\n";
+		passed = false;
+	}
+	cowSim.TimerInterrupt();
+	cowSim.SimExit();					//PID 2 frees frame 1 and leaves frame 0 to PID 1
+	if (cowSim.GetMemory().size() != 2 || cowSim.GetMemory()[0].PID != 1 || cowSim.GetMemory()[0].references != 1
+		|| cowSim.GetMemory()[1].frameNumber != 2) {
+		std::cout<<"Failed to free a shared frame only when its last owner exits (line 434)\n";
+		passed = false;
+	}
+
+	SimOptions pagingOptions;
+	pagingOptions.swapDisk = 0;
+	pagingOptions.pageInCluster = 4;
+	SimOS pagingSim(1,40,10,pagingOptions);
+	pagingSim.NewProcess();
+	pagingSim.AccessMemoryAddress(25);	//page 2 faults, pages 0-3 are read in one job
+	if (pagingSim.GetCPU() != 0 || pagingSim.GetDisk(0).PID != 1 || pagingSim.GetDisk(0).fileName != "swap"
+		|| pagingSim.GetDisk(0).block != 0 || pagingSim.GetDisk(0).size != 4) {
+		std::cout<<"Failed to block a page fault on the swap disk (line 446)\n";
+		passed = false;
+	}
+	pagingSim.DiskJobCompleted(0);
+	pagingSim.WriteMemoryAddress(5);		//page 0 is dirty
+	pagingSim.AccessMemoryAddress(45);	//pages 4-7 replace pages 0-3, page 4 goes to frame 0
+	pagingSim.DiskJobCompleted(0);		//page 0 is written back
+	if (pagingSim.GetCPU() != 1 || pagingSim.GetMemory()[0].pageNumber != 4 || pagingSim.GetDisk(0).PID != 0
+		|| pagingSim.GetDisk(0).block != 0 || pagingSim.GetMemoryStats().pageIns != 2 || pagingSim.GetMemoryStats().writeBacks != 1) {
+		std::cout<<"Failed to write back a dirty page on eviction (line 455)\n";
+		passed = false;
+	}
+
+	SimOS statsSim(1,10,1);
+	statsSim.NewProcess();				//CPU: 1
+	statsSim.NewProcess();
+	statsSim.NewProcess();				//ready: 2 3
+	statsSim.DiskReadRequest(0, "a");	//CPU: 2
+	statsSim.DiskReadRequest(0, "b");	//CPU: 3, disk queue: 2
+	statsSim.TimerInterrupt();			//CPU: 3 again
+	if (statsSim.GetCoreStats().contextSwitches != 4 || statsSim.GetCoreStats().maxReadyQueue != 2
+		|| statsSim.GetDiskStats(0).maxQueueDepth != 1) {
+		std::cout<<"Failed to count context switches and queue depths (line 468)\n";
+		passed = false;
+	}
+
+	SimOptions numaOptions;
+	numaOptions.numberOfCores = 2;
+	numaOptions.numaNodes = 2;
+	numaOptions.numaPlacement = NumaPlacement::Interleave;
+	SimOS numaSim(1,4,1,numaOptions);	//node 0: frames 0-1, node 1: frames 2-3
+	numaSim.NewProcess();				//core 0, node 0
+	numaSim.AccessMemoryAddress(0);		//frame 0
+	numaSim.AccessMemoryAddress(1);		//frame 2
+	numaSim.AccessMemoryAddress(2);		//frame 1
+	numaSim.AccessMemoryAddress(1);		//remote hit
+	if (numaSim.GetMemory()[1].pageNumber != 2 || numaSim.GetFrameNode(2) != 1 || numaSim.GetNumaStats(0).localAccesses != 2
+		|| numaSim.GetNumaStats(1).remoteAccesses != 2 || numaSim.GetNumaStats(1).usedFrames != 1) {
+		std::cout<<"Failed to interleave pages over NUMA nodes (line 484)\n";
+		passed = false;
+	}
+
+	numaOptions.numaPlacement = NumaPlacement::FirstTouch;
+	SimOS firstTouchSim(1,4,1,numaOptions);
+	firstTouchSim.NewProcess();
+	firstTouchSim.AccessMemoryAddress(0);
+	firstTouchSim.AccessMemoryAddress(1);
+	firstTouchSim.AccessMemoryAddress(2);	//node 0 is full, frame 2
+	if (firstTouchSim.GetMemory()[2].pageNumber != 2 || firstTouchSim.GetNumaStats(0).usedFrames != 2
+		|| firstTouchSim.GetNumaStats(1).fallbacks != 1 || firstTouchSim.GetNumaStats(1).remoteAccesses != 1) {
+		std::cout<<"Failed to fall back to another NUMA node (line 496)\n";
+		passed = false;
+	}
+
+	SimOptions aheadOptions;
+	aheadOptions.readAhead = 8;
+	SimOS aheadSim(1,16,1,aheadOptions);
+	aheadSim.NewProcess();
+	aheadSim.AccessMemoryAddress(10);
+	aheadSim.AccessMemoryAddress(12);
+	aheadSim.AccessMemoryAddress(14);	//stride 2 repeats, pages 16 18 20 22 are read ahead
+	aheadSim.AccessMemoryAddress(16);	//hit
+	aheadSim.AccessMemoryAddress(18);	//hit
+	if (aheadSim.GetMemoryStats().faults != 3 || aheadSim.GetMemoryStats().prefetched != 4 || aheadSim.GetMemoryStats().prefetchHits != 2
+		|| aheadSim.GetMemory().size() != 7 || aheadSim.GetMemory()[6].pageNumber != 22) {
+		std::cout<<"Failed to read ahead a strided stream (line 511)\n";
+		passed = false;
+	}
+
+	//TESTING THE SIMULATED CLOCK
+	ClockConfig clock;
+	clock.quantum = 3;
+	clock.diskLatency = 2;
+	EventSimulator clockSim(1,10,1,SimOptions(),clock);
+	clockSim.Inject(Job{0, {Burst{5, 0, 0, 2}, Burst{1}}});	//PID 1 reads 2 blocks after 5 ticks
+	clockSim.Inject(Job{1, {Burst{2}}});					//PID 2
+	clockSim.Run();		//1 runs 0-3, 2 runs 3-5, 1 runs 5-7, reads 7-11, runs 11-12
+	if (clockSim.Now() != 12 || clockSim.Finished().size() != 2 || clockSim.Finished()[0].PID != 2
+		|| clockSim.Finished()[0].Turnaround() != 4 || clockSim.Finished()[1].Wait() != 2 || clockSim.Finished()[1].diskTime != 4
+		|| clockSim.Stats().coreBusy[0] != 8 || clockSim.Stats().diskBusy[0] != 4 || clockSim.Sim().NextPID() != 3) {
+		std::cout<<"Failed to fire quantum expiries and disk completions on the clock (line 525)\n";
+		passed = false;
+	}
+
+	//TESTING TRACE CONVERSION AND REPLAY
+	std::istringstream textTrace(
+		"config 1 40 10\n"
+		"new			# PID 1\n"
+		"access 5\n"
+		"read 0 a.txt\n"
+		"fork			# rejected, the CPU is idle\n"
+		"done 0\n"
+		"access 25\n");
+	std::uint64_t converted = ConvertTextTrace(textTrace, "roundTrip.trace");
+	{
+		TraceFile trace("roundTrip.trace");
+		SimOS replaySim(trace.Header().numberOfDisks, trace.Header().amountOfRAM, trace.Header().pageSize);
+		ReplayStats replayed = ReplayTrace(replaySim, trace);
+		if (converted != 6 || trace.FileNames().size() != 1 || replayed.events != 6 || replayed.rejected != 1
+			|| replaySim.GetCPU() != 1 || replaySim.GetMemory().size() != 2 || replaySim.GetMemory()[1].pageNumber != 2) {
+			std::cout<<"Failed to replay a converted text trace (line 546)\n";
+			passed = false;
+		}
+	}
+	std::remove("roundTrip.trace");
+
+	std::istringstream badTrace("new\nacess 5\n");
+	try {
+		ConvertTextTrace(badTrace, "bad.trace");
+		std::cout<<"Failed to reject a malformed trace line (line 546)\n";
+		passed = false;
+	}
+	catch (const std::runtime_error& err) {
+		if (std::string(err.what()).find("line 2") == std::string::npos || std::ifstream("bad.trace")) {
+			std::cout<<"Failed to name the malformed trace line and drop the output (line 561)\n";
+			passed = false;
+		}
+	}
+
+	std::istringstream extentTrace(
+		"config 1 40 10\n"
+		"new\n"
+		"new\n"
+		"read 0 a.txt 700 8\n"
+		"read 0 b.txt\n");
+	converted = ConvertTextTrace(extentTrace, "extent.trace");
+	{
+		TraceFile trace("extent.trace");
+		SimOS replaySim(trace.Header().numberOfDisks, trace.Header().amountOfRAM, trace.Header().pageSize);
+		ReplayStats extentStats = ReplayTrace(replaySim, trace);
+		if (converted != 5 || extentStats.events != 4 || trace.Header().version != TRACE_VERSION || replaySim.GetDisk(0).block != 700 || replaySim.GetDisk(0).size != 8
+			|| replaySim.GetDiskQueue(0).size() != 1 || replaySim.GetDiskQueue(0)[0].block != 0) {
+			std::cout<<"Failed to carry the block and size of a traced disk read (line 578)\n";
+			passed = false;
+		}
+	}
+	std::remove("extent.trace");
+
+	//TESTING LRU VICTIMS AND FREED FRAMES
+	SimOS victimSim(1,4,1);
+	victimSim.NewProcess();	//1
+	victimSim.SimFork();	//2
+	victimSim.AccessMemoryAddress(0);	//frame 0
+	victimSim.TimerInterrupt();	//CPU: 2
+	victimSim.AccessMemoryAddress(0);	//frame 1
+	victimSim.AccessMemoryAddress(1);	//frame 2
+	victimSim.TimerInterrupt();	//CPU: 1
+	victimSim.AccessMemoryAddress(1);	//frame 3, RAM is full
+	victimSim.TimerInterrupt();	//CPU: 2
+	victimSim.SimExit();	//2 turns to zombie, frames 1 and 2 are free again
+	victimSim.AccessMemoryAddress(2);	//lowest free frame 1 instead of a victim
+	victimSim.AccessMemoryAddress(3);	//frame 2
+	victimSim.AccessMemoryAddress(0);	//hit, frame 3 now holds the least recently used page
+	victimSim.AccessMemoryAddress(4);	//replaces page 1 in frame 3
+	ram = victimSim.GetMemory();
+	if (ram.size() != 4 || ram[0].pageNumber != 0 || ram[1].pageNumber != 2 || ram[2].pageNumber != 3 || ram[3].pageNumber != 4
+		|| victimSim.GetMemoryStats().evictions != 1) {
+		std::cout<<"Failed to pick the least recently used victim after reusing freed frames (line 603)\n";
+		passed = false;
+	}
+
+	//TESTING SPARSE PAGE TABLES
+	SimOS sparseSim(1,4,1);
+	sparseSim.NewProcess();	//1
+	sparseSim.AccessMemoryAddress(1000000);	//page far beyond the 4 frames
+	sparseSim.AccessMemoryAddress(4);	//page equal to the number of frames
+	sparseSim.AccessMemoryAddress(1000000);	//hit
+	ram = sparseSim.GetMemory();
+	if (ram.size() != 2 || ram[0].pageNumber != 1000000 || ram[1].pageNumber != 4 || sparseSim.GetMemoryStats().faults != 2) {
+		std::cout<<"Failed to map pages above the number of frames (line 616)\n";
+		passed = false;
+	}
+
+	//TESTING THE PROCESS TABLE
+	ProcessTable table;
+	for (int pid = 1; pid <= 3000; ++pid) table.Create(pid);
+	for (int pid = 1; pid < 3000; ++pid) table.Release(pid);	//the chunks of PIDs 1-2047 are freed
+	std::size_t capacity = table.Capacity();
+	bool lookedUp = table.Find(2999) == nullptr && table.Find(5000) == nullptr && table.Find(3000) != nullptr;
+	if (!lookedUp || capacity != 1024 || table.Capacity() != capacity || table.size() != 1) {
+		std::cout<<"Failed to reclaim released PID slots without inserting unknown PIDs (line 627)\n";
+		passed = false;
+	}
+
+	SimOS lookupSim(1,10,1);
+	lookupSim.NewProcess();	//1
+	lookupSim.SimFork();	//2
+	lookupSim.TimerInterrupt();	//CPU: 2
+	lookupSim.SimExit();	//2 turns to zombie
+	lookupSim.SimWait();	//1 reaps it
+	bool unknownRejected = false;
+	try {
+		lookupSim.SetPriority(2, 1);
+	}
+	catch (const std::out_of_range&) {
+		unknownRejected = true;
+	}
+	if (!unknownRejected || lookupSim.GetCPU() != 1 || lookupSim.GetReadyQueue().size() != 0) {
+		std::cout<<"Failed to reject a reaped PID (line 645)\n";
+		passed = false;
+	}
+
+	//TESTING QUEUE REMOVAL
+	SimOS queueSim(1,10,1);
+	queueSim.NewProcess();	//1
+	queueSim.DiskJobCompleted(0);	//idle disk
+	if (queueSim.GetCPU() != 1 || queueSim.GetReadyQueue().size() != 0) {
+		std::cout<<"Failed to ignore a completed job of an idle disk (line 654)\n";
+		passed = false;
+	}
+
+	queueSim.SimFork();	//2
+	queueSim.SimFork();	//3
+	queueSim.TimerInterrupt();	//CPU: 2 | Q: 3, 1
+	queueSim.DiskReadRequest(0, "a.txt");	//CPU: 3 | Q: 1 | Disk: 2
+	queueSim.SimFork();	//4
+	queueSim.DiskReadRequest(0, "b.txt");	//CPU: 1 | Q: 4 | Disk: 2 | DQ: 3
+	queueSim.SimExit();	//1 takes 2 and 3 with it, 3 takes 4
+	if (queueSim.GetCPU() != NO_PROCESS || queueSim.GetReadyQueue().size() != 0 || queueSim.GetDisk(0).PID != NO_PROCESS
+		|| queueSim.GetDiskQueue(0).size() != 0 || queueSim.DiskQueueSize(0) != 0) {
+		std::cout<<"Failed to remove killed processes from the ready and disk queues (line 666)\n";
+		passed = false;
+	}
+
+	//TESTING THE PROFILER
+	SimOS profiledSim(1,2,1);
+	profiledSim.NewProcess();	//1
+	profiledSim.NewProcess();	//2
+	profiledSim.AccessMemoryAddress(0);	//1 misses
+	profiledSim.AccessMemoryAddress(0);	//1 hits
+	profiledSim.TimerInterrupt();	//CPU: 2
+	profiledSim.AccessMemoryAddress(0);	//2 misses
+	profiledSim.AccessMemoryAddress(1);	//2 misses, page 0 of 1 is evicted
+	std::ostringstream profileJson, profileCsv;
+	profiledSim.Profiler().WriteJson(profileJson);
+	profiledSim.Profiler().WriteCsv(profileCsv);
+	const SimProfiler& profiler = profiledSim.Profiler();
+	bool profiled = SimProfiler::ENABLED
+		? profiler.Pages().size() == 2 && profiler.Pages().at(1).hits == 1 && profiler.Pages().at(1).misses == 1
+			&& profiler.Pages().at(1).evictions == 1 && profiler.Pages().at(2).misses == 2 && profiler.ContextSwitches()[0] == 2
+			&& profileJson.str().find("{\"pid\":1,\"hits\":1,\"misses\":1,\"evictions\":1}") != std::string::npos
+			&& profileCsv.str().find("pages,2,misses,2\n") != std::string::npos
+		: profiler.Pages().empty() && profileJson.str().find("\"enabled\":false") != std::string::npos
+			&& profileCsv.str().find("profiler,,enabled,0\n") != std::string::npos;
+	if (!profiled) {
+		std::cout<<"Failed to count page hits, misses, evictions and context switches (line 692)\n";
+		passed = false;
+	}
+
+	profiledSim.TimerInterrupt();	//CPU: 1
+	profiledSim.SimExit();	//1 exits, CPU: 2
+	if (SimProfiler::ENABLED && (profiler.Pages().count(1) != 0 || profiler.ExitedPages().hits != 1
+		|| profiler.ExitedPages().evictions != 1 || profiler.ContextSwitches()[0] != 4)) {
+		std::cout<<"Failed to fold the page counters of an exited process (line 699)\n";
+		passed = false;
+	}
+
+	//TESTING A REFUSED CHECKPOINT LEAVES THE SIMULATOR ALONE
+	SimOS kept(1,10,1);
+	kept.NewProcess();	//1
+	kept.AccessMemoryAddress(5);
+	std::vector<unsigned char> keptImage = kept.Checkpoint();
+	int keptRefused = 0;
+	bool keptSame = true;
+	for (std::size_t at = CHECKPOINT_HEADER_SIZE; at < keptImage.size(); ++at) {
+		std::vector<unsigned char> damaged = keptImage;
+		damaged[at] ^= 0xFF;
+		std::uint64_t sum = CheckpointChecksum(damaged.data() + CHECKPOINT_HEADER_SIZE, damaged.size() - CHECKPOINT_HEADER_SIZE);
+		std::memcpy(damaged.data() + CHECKPOINT_HEADER_SIZE - sizeof(sum), &sum, sizeof(sum));
+		try {
+			kept.RestoreCheckpoint(damaged.data(), damaged.size());
+			kept.RestoreCheckpoint(keptImage.data(), keptImage.size());
+		}
+		catch (const std::runtime_error&) {
+			++keptRefused;
+			keptSame = keptSame && kept.GetCPU() == 1 && kept.GetReadyQueue().empty() && kept.GetMemory().size() == 1
+				&& kept.GetMemory()[0].pageNumber == 5 && kept.GetMemory()[0].PID == 1;
+		}
+	}
+	kept.SimFork();	//2
+	if (keptRefused == 0 || !keptSame || kept.GetReadyQueue() != std::deque<int>{2}) {
+		std::cout<<"Failed to keep the state after a refused checkpoint (line 728)\n";
+		passed = false;
+	}
+
 	if (passed) std::cout << "These custom tests are passed" << std::endl;
+	return passed ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "pageTable.h"
+
+unsigned long long PageTable::Find(unsigned long long page) const
+{
+    if (size_ == 0)
+        return NO_FRAME;
+    unsigned long long mask = slots_.size() - 1;
+    for (unsigned long long i = Home(page); ; i = (i + 1) & mask)
+    {
+        if (slots_[i].frame == NO_FRAME)
+            return NO_FRAME;
+        if (slots_[i].page == page)
+            return slots_[i].frame;
+    }
+}
+
+void PageTable::Map(unsigned long long page, unsigned long long frame)
+{
+    if ((size_ + 1) * 4 > slots_.size() * 3)
+        Grow();
+    unsigned long long mask = slots_.size() - 1;
+    for (unsigned long long i = Home(page); ; i = (i + 1) & mask)
+    {
+        if (slots_[i].frame == NO_FRAME)
+        {
+            slots_[i] = Slot{page, frame};
+            ++size_;
+            return;
+        }
+        if (slots_[i].page == page)
+        {
+            slots_[i].frame = frame;
+            return;
+        }
+    }
+}
+
+void PageTable::Unmap(unsigned long long page)
+{
+    if (size_ == 0)
+        return;
+    unsigned long long mask = slots_.size() - 1;
+    unsigned long long i = Home(page);
+    while (slots_[i].page != page || slots_[i].frame == NO_FRAME)
+    {
+        if (slots_[i].frame == NO_FRAME)
+            return;
+        i = (i + 1) & mask;
+    }
+
+    // Backward shift deletion keeps probe chains intact without tombstones
+    --size_;
+    for (unsigned long long j = (i + 1) & mask; slots_[j].frame != NO_FRAME; j = (j + 1) & mask)
+    {
+        unsigned long long home = Home(slots_[j].page);
+        if (((j - home) & mask) >= ((j - i) & mask))
+        {
+            slots_[i] = slots_[j];
+            i = j;
+        }
+    }
+    slots_[i].frame = NO_FRAME;
+}
+
+void PageTable::Clear()
+{
+    std::vector<Slot>().swap(slots_);
+    size_ = 0;
+    shift_ = 64;
+}
+
+void PageTable::Grow()
+{
+    std::vector<Slot> old;
+    old.swap(slots_);
+    unsigned long long capacity = old.empty() ? 8 : old.size() * 2;
+    slots_.assign(capacity, Slot{});
+    shift_ = 64;
+    for (unsigned long long c = capacity; c > 1; c >>= 1)
+        --shift_;
+    size_ = 0;
+    for (const auto& slot : old)
+    {
+        if (slot.frame != NO_FRAME)
+            Map(slot.page, slot.frame);
+    }
+}
+
+void PageTable::Save(CheckpointWriter& out) const
+{
+    out.Write(size_);
+    out.Write(shift_);
+    out.WriteVector(slots_);
+}
+
+void PageTable::Load(CheckpointReader& in)
+{
+    size_ = in.Read<unsigned long long>();
+    shift_ = in.Read<unsigned int>();
+    in.ReadVector(slots_);
+
+    // A power of two of at least 8 slots, below the load factor so probing ends, and every page reachable
+    // from its home slot without an empty slot or a copy of the page in between
+    unsigned long long capacity = slots_.size();
+    CheckCheckpoint(capacity == 0 ? size_ == 0 && shift_ == 64
+        : capacity >= 8 && (capacity & (capacity - 1)) == 0 && shift_ > 0 && shift_ < 64 && (1ULL << (64 - shift_)) == capacity
+            && size_ * 4 <= capacity * 3);
+    unsigned long long mask = capacity - 1;
+    unsigned long long used = 0;
+    for (unsigned long long i = 0; i < capacity; ++i)
+    {
+        if (slots_[i].frame == NO_FRAME)
+            continue;
+        ++used;
+        for (unsigned long long j = Home(slots_[i].page); j != i; j = (j + 1) & mask)
+            CheckCheckpoint(slots_[j].frame != NO_FRAME && slots_[j].page != slots_[i].page);
+    }
+    CheckCheckpoint(used == size_);
+}
@@ -0,0 +1,80 @@
+#ifndef PAGE_TABLE_H
+#define PAGE_TABLE_H
+
+#include <vector>
+
+#include "checkpoint.h"
+
+constexpr unsigned long long NO_FRAME{ ~0ULL };
+
+/**
+ * Sparse per-process page table mapping logical page numbers to frame numbers.
+ * Only pages that are resident take space, so an empty table costs nothing and any 64-bit page number is valid.
+ * Implemented as an open addressing hash table with linear probing, lookups and updates are O(1) on average.
+ */
+class PageTable
+{
+    private:
+        struct Slot
+        {
+            unsigned long long page;
+            unsigned long long frame{NO_FRAME};
+        };
+
+        std::vector<Slot> slots_;
+        unsigned long long size_{0};
+        unsigned int shift_{64};
+
+        unsigned long long Home(unsigned long long page) const
+        {
+            return (page * 0x9E3779B97F4A7C15ULL) >> shift_;
+        }
+
+        void Grow();
+
+    public:
+        /**
+         * Returns the frame holding the page or NO_FRAME if the page isn't resident.
+        */
+        unsigned long long Find(unsigned long long page) const;
+
+        /**
+         * Records that the page now lives in the given frame.
+        */
+        void Map(unsigned long long page, unsigned long long frame);
+
+        /**
+         * Forgets the page. Does nothing if the page isn't mapped.
+        */
+        void Unmap(unsigned long long page);
+
+        /**
+         * Drops every mapping and releases the table storage.
+        */
+        void Clear();
+
+        unsigned long long size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        /**
+         * Writes or restores the table image, slots included, so a restored table probes exactly the same way.
+         * Load throws std::runtime_error if the image breaks the hash table invariants.
+        */
+        void Save(CheckpointWriter& out) const;
+        void Load(CheckpointReader& in);
+
+        /**
+         * Calls visit(page, frame) for every resident page, in no particular order.
+        */
+        template<typename Visitor>
+        void ForEach(Visitor&& visit) const
+        {
+            for (const auto& slot : slots_)
+            {
+                if (slot.frame != NO_FRAME)
+                    visit(slot.page, slot.frame);
+            }
+        }
+};
+
+#endif
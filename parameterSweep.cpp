@@ -0,0 +1,153 @@
+#include "parameterSweep.h"
+
+#include <algorithm>
+#include <deque>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    /**
+     * Run queue of one worker. Padded to a cache line so the locks of neighbouring workers don't share one.
+    */
+    struct alignas(64) WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> configs;
+    };
+
+    /**
+     * The owner takes configurations from the front of its own queue, thieves from the back of the others.
+     * Nothing is added once the workers started, so a worker is done when every queue is empty.
+    */
+    bool NextConfig(std::vector<WorkQueue>& queues, unsigned int worker, std::size_t& config)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker].mutex);
+            if (!queues[worker].configs.empty())
+            {
+                config = queues[worker].configs.front();
+                queues[worker].configs.pop_front();
+                return true;
+            }
+        }
+        for (std::size_t offset = 1; offset < queues.size(); ++offset)
+        {
+            WorkQueue& victim = queues[(worker + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.configs.empty())
+            {
+                config = victim.configs.back();
+                victim.configs.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    SweepResult RunConfig(const TraceFile& trace, const SweepConfig& config)
+    {
+        SweepResult result;
+        result.config = config;
+        if (config.numberOfDisks < 0 || config.pageSize == 0 || config.amountOfRAM < config.pageSize)
+        {
+            result.error = "Configuration has a negative disk count or no page frames\n";
+            return result;
+        }
+        std::unique_ptr<SimOS> sim;
+        try
+        {
+            sim = std::make_unique<SimOS>(config.numberOfDisks, config.amountOfRAM, config.pageSize, config.options);
+        }
+        catch (const std::invalid_argument& err)
+        {
+            result.error = err.what();
+            return result;
+        }
+        result.replay = ReplayTrace(*sim, trace);
+        result.memory = sim->GetMemoryStats();
+        for (int core = 0; core < sim->NumberOfCores(); ++core)
+        {
+            CoreStats stats = sim->GetCoreStats(core);
+            result.contextSwitches += stats.contextSwitches;
+            result.maxReadyQueue = std::max(result.maxReadyQueue, stats.maxReadyQueue);
+        }
+        for (int disk = 0; disk < config.numberOfDisks; ++disk)
+        {
+            DiskStats stats = sim->GetDiskStats(disk);
+            result.maxDiskQueue = std::max(result.maxDiskQueue, stats.maxQueueDepth);
+            result.diskRequests += stats.served;
+            result.totalDiskQueueWait += stats.totalQueueWait;
+        }
+        return result;
+    }
+}
+
+std::vector<SweepConfig> SweepGrid(const std::vector<int>& numberOfDisks, const std::vector<unsigned long long>& amountsOfRAM,
+    const std::vector<unsigned int>& pageSizes, const SimOptions& options)
+{
+    std::vector<SweepConfig> configs;
+    configs.reserve(numberOfDisks.size() * amountsOfRAM.size() * pageSizes.size());
+    for (int disks : numberOfDisks)
+    {
+        for (unsigned long long ram : amountsOfRAM)
+        {
+            for (unsigned int pageSize : pageSizes)
+                configs.push_back(SweepConfig{disks, ram, pageSize, options});
+        }
+    }
+    return configs;
+}
+
+std::vector<SweepResult> RunSweep(const TraceFile& trace, const std::vector<SweepConfig>& configs, unsigned int threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned int>(std::max<std::size_t>(1, std::min<std::size_t>(threads, configs.size())));
+
+    // Dealt round robin, so every worker starts with a mix of the grid
+    std::vector<WorkQueue> queues(threads);
+    for (std::size_t config = 0; config < configs.size(); ++config)
+        queues[config % threads].configs.push_back(config);
+
+    std::vector<SweepResult> results(configs.size());
+    auto work = [&](unsigned int worker) {
+        std::size_t config;
+        while (NextConfig(queues, worker, config))
+            results[config] = RunConfig(trace, configs[config]);
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned int worker = 1; worker < threads; ++worker)
+        workers.emplace_back(work, worker);
+    work(0);
+    for (std::thread& worker : workers)
+        worker.join();
+    return results;
+}
+
+void WriteSweepCsv(std::ostream& output, const std::vector<SweepResult>& results, std::ostream* errors)
+{
+    output << "numberOfDisks,amountOfRAM,pageSize,accesses,faults,faultRate,evictions,contextSwitches,"
+           << "maxReadyQueue,maxDiskQueue,meanDiskQueueWait,rejected,seconds\n" << std::setprecision(6);
+    for (const SweepResult& result : results)
+    {
+        const SweepConfig& config = result.config;
+        if (!result.error.empty())
+        {
+            if (errors != nullptr)
+                *errors << config.numberOfDisks << "," << config.amountOfRAM << "," << config.pageSize << ": " << result.error;
+            continue;
+        }
+        output << config.numberOfDisks << "," << config.amountOfRAM << "," << config.pageSize << ","
+               << result.memory.accesses << "," << result.memory.faults << "," << result.memory.FaultRate() << ","
+               << result.memory.evictions << "," << result.contextSwitches << "," << result.maxReadyQueue << ","
+               << result.maxDiskQueue << "," << result.MeanDiskQueueWait() << "," << result.replay.rejected << ","
+               << result.replay.seconds << "\n";
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "simOS.h"
+#include "traceReplay.h"
+
+/**
+ * One machine configuration of a sweep, the arguments of the SimOS constructor.
+ */
+struct SweepConfig
+{
+    int numberOfDisks {1};
+    unsigned long long amountOfRAM {0};
+    unsigned int pageSize {0};
+    SimOptions options;
+};
+
+/**
+ * Outcome of replaying the trace on one configuration. Scheduling counters are summed over the cores,
+ * queue depths are the maximum over all cores and disks. error is set instead when the SimOS
+ * constructor rejected the configuration, the counters are zero then.
+ */
+struct SweepResult
+{
+    SweepConfig config;
+    ReplayStats replay;
+    MemoryStats memory;
+    unsigned long long contextSwitches {0};
+    unsigned long long maxReadyQueue {0};
+    unsigned long long maxDiskQueue {0};
+    unsigned long long diskRequests {0};
+    unsigned long long totalDiskQueueWait {0};
+    std::string error;
+
+    double MeanDiskQueueWait() const { return diskRequests == 0 ? 0.0 : static_cast<double>(totalDiskQueueWait) / diskRequests; }
+};
+
+/**
+ * Every combination of the given disk counts, RAM sizes and page sizes, all with the same options.
+ */
+std::vector<SweepConfig> SweepGrid(const std::vector<int>& numberOfDisks, const std::vector<unsigned long long>& amountsOfRAM,
+    const std::vector<unsigned int>& pageSizes, const SimOptions& options = SimOptions());
+
+/**
+ * Replays the trace once per configuration, one SimOS per configuration spread over threads workers,
+ * 0 meaning one per hardware thread. All workers read the events straight from the shared, read-only
+ * mapping of the trace. Configurations are dealt to per worker deques, and a worker that runs out of
+ * its own takes the last ones of another worker, so long runs don't leave the other cores idle.
+ * Results come back in the order of configs.
+ */
+std::vector<SweepResult> RunSweep(const TraceFile& trace, const std::vector<SweepConfig>& configs, unsigned int threads = 0);
+
+/**
+ * Writes the results as one CSV table with a header line. Rejected configurations are left out
+ * and reported on errors, if it is given.
+ */
+void WriteSweepCsv(std::ostream& output, const std::vector<SweepResult>& results, std::ostream* errors = nullptr);
+
+#endif
@@ -0,0 +1,245 @@
+#include "processTable.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+Process& ProcessTable::Create(int pid)
+{
+    if (pid <= 0 || pid < nextPID_)
+    {
+        throw std::logic_error("Process IDs must be positive and increasing\n");
+    }
+    long long chunkNumber = static_cast<long long>(pid) >> CHUNK_BITS;
+    if (chunks_.empty())
+    {
+        firstChunk_ = chunkNumber;
+    }
+    while (firstChunk_ + static_cast<long long>(chunks_.size()) <= chunkNumber)
+    {
+        chunks_.push_back(nullptr);
+    }
+    auto& chunk = chunks_[chunkNumber - firstChunk_];
+    if (!chunk)
+    {
+        chunk = std::make_unique<Chunk>();
+    }
+
+    // Chunks skipped over by this PID can't receive new processes anymore
+    long long previousChunk = static_cast<long long>(nextPID_) >> CHUNK_BITS;
+    nextPID_ = pid + 1;
+    for (long long number = previousChunk; number < chunkNumber; ++number)
+    {
+        Reclaim(number);
+    }
+
+    Process& process = chunk->slots[pid & (CHUNK_SIZE - 1)];
+    process = Process();
+    process.PID = pid;
+    ++chunk->live;
+    ++live_;
+    return process;
+}
+
+void ProcessTable::Release(int pid)
+{
+    Chunk* chunk = ChunkOf(pid);
+    if (chunk == nullptr)
+        return;
+    Process& process = chunk->slots[pid & (CHUNK_SIZE - 1)];
+    if (process.PID == 0)
+        return;
+    process = Process();
+    --chunk->live;
+    --live_;
+    Reclaim(static_cast<long long>(pid) >> CHUNK_BITS);
+}
+
+void ProcessTable::Reclaim(long long chunkNumber)
+{
+    long long index = chunkNumber - firstChunk_;
+    if (index < 0 || index >= static_cast<long long>(chunks_.size()))
+        return;
+    auto& chunk = chunks_[index];
+    // Only chunks whose whole PID range has been issued can be freed
+    bool exhausted = ((chunkNumber + 1) << CHUNK_BITS) <= nextPID_;
+    if (chunk && chunk->live == 0 && exhausted)
+    {
+        chunk.reset();
+    }
+    while (!chunks_.empty() && !chunks_.front() && ((firstChunk_ + 1) << CHUNK_BITS) <= nextPID_)
+    {
+        chunks_.pop_front();
+        ++firstChunk_;
+    }
+}
+
+namespace
+{
+    /**
+     * Fixed size part of a Process in a checkpoint.
+    */
+    struct ProcessRecord
+    {
+        int PID;
+        int parentPID;
+        int core;
+        int priority;
+        int schedLevel;
+        int ioDisk;
+        FileId ioFile;
+        int homeNode;
+        int pageIn;
+        bool isWaiting;
+        bool isZombie;
+        bool isReady;
+        bool pageInWrite;
+        unsigned long long residentHead;
+        unsigned long long residentCount;
+        unsigned long long sharedCount;
+        unsigned long long vruntime;
+        unsigned long long schedKey;
+        unsigned long long ioBlock;
+        unsigned long long ioSize;
+        unsigned long long ioSeq;
+        unsigned long long ioQueuedAt;
+        unsigned long long faultPage;
+        unsigned long long streamPage;
+        long long streamStride;
+        unsigned long long readAheadWindow;
+    };
+
+    static_assert(sizeof(ProcessRecord) == 144, "ProcessRecord must not contain padding");
+}
+
+void ProcessTable::Save(CheckpointWriter& out) const
+{
+    out.Write<std::uint64_t>(live_);
+    out.Write(nextPID_);
+    for (std::size_t index = 0; index < chunks_.size(); ++index)
+    {
+        if (!chunks_[index])
+            continue;
+        for (const Process& process : chunks_[index]->slots)
+        {
+            if (process.PID == 0)
+                continue;
+            out.Write(ProcessRecord{process.PID, process.parentPID, process.core, process.priority, process.schedLevel,
+                process.ioDisk, process.ioFile, process.homeNode, static_cast<int>(process.pageIn), process.isWaiting,
+                process.isZombie, process.isReady, process.pageInWrite, process.residentHead, process.residentCount,
+                process.sharedCount, process.vruntime, process.schedKey, process.ioBlock, process.ioSize, process.ioSeq,
+                process.ioQueuedAt, process.faultPage, process.streamPage, process.streamStride, process.readAheadWindow});
+            out.WriteVector(process.children);
+            process.pageTable.Save(out);
+            process.hugePageTable.Save(out);
+            out.WriteVector(process.hugeRanges);
+        }
+    }
+}
+
+void ProcessTable::Load(CheckpointReader& in)
+{
+    chunks_.clear();
+    firstChunk_ = 0;
+    nextPID_ = 0;
+    live_ = 0;
+    std::uint64_t count = in.Read<std::uint64_t>();
+    int savedNextPID = in.Read<int>();
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        ProcessRecord record = in.Read<ProcessRecord>();
+        CheckCheckpoint(record.PID > 0 && record.PID >= nextPID_ && IsBool(record.isWaiting) && IsBool(record.isZombie)
+            && IsBool(record.isReady) && IsBool(record.pageInWrite) && record.pageIn >= 0
+            && record.pageIn <= static_cast<int>(PageIn::Huge));
+        Process& process = Create(record.PID);
+        process.parentPID = record.parentPID;
+        process.isWaiting = record.isWaiting;
+        process.isZombie = record.isZombie;
+        process.isReady = record.isReady;
+        process.pageInWrite = record.pageInWrite;
+        process.pageIn = static_cast<PageIn>(record.pageIn);
+        process.faultPage = record.faultPage;
+        process.streamPage = record.streamPage;
+        process.streamStride = record.streamStride;
+        process.readAheadWindow = record.readAheadWindow;
+        process.core = record.core;
+        process.homeNode = record.homeNode;
+        process.priority = record.priority;
+        process.schedLevel = record.schedLevel;
+        process.ioDisk = record.ioDisk;
+        process.ioFile = record.ioFile;
+        process.residentHead = record.residentHead;
+        process.residentCount = record.residentCount;
+        process.sharedCount = record.sharedCount;
+        process.vruntime = record.vruntime;
+        process.schedKey = record.schedKey;
+        process.ioBlock = record.ioBlock;
+        process.ioSize = record.ioSize;
+        process.ioSeq = record.ioSeq;
+        process.ioQueuedAt = record.ioQueuedAt;
+        in.ReadVector(process.children);
+        process.pageTable.Load(in);
+        process.hugePageTable.Load(in);
+        in.ReadVector(process.hugeRanges);
+    }
+    CheckCheckpoint(savedNextPID >= nextPID_);
+    nextPID_ = savedNextPID;
+}
+
+Process& ProcessTable::Queued(int pid)
+{
+    Process* process = Find(pid);
+    CheckCheckpoint(process != nullptr && process->queue == nullptr);
+    return *process;
+}
+
+std::size_t ProcessTable::Capacity() const
+{
+    std::size_t allocated = 0;
+    for (const auto& chunk : chunks_)
+    {
+        if (chunk)
+            ++allocated;
+    }
+    return allocated * CHUNK_SIZE;
+}
+
+void PidQueue::PushBack(ProcessTable& table, int pid)
+{
+    Process& process = *table.Find(pid);
+    process.queue = this;
+    process.queuePrev = tail_;
+    process.queueNext = NO_PROCESS;
+    if (tail_ != NO_PROCESS)
+        table.Find(tail_)->queueNext = pid;
+    else
+        head_ = pid;
+    tail_ = pid;
+    ++size_;
+}
+
+int PidQueue::PopFront(ProcessTable& table)
+{
+    int pid = head_;
+    if (pid != NO_PROCESS)
+        Remove(table, pid);
+    return pid;
+}
+
+void PidQueue::Remove(ProcessTable& table, int pid)
+{
+    Process& process = *table.Find(pid);
+    if (process.queue != this)
+        return;
+    if (process.queuePrev != NO_PROCESS)
+        table.Find(process.queuePrev)->queueNext = process.queueNext;
+    else
+        head_ = process.queueNext;
+    if (process.queueNext != NO_PROCESS)
+        table.Find(process.queueNext)->queuePrev = process.queuePrev;
+    else
+        tail_ = process.queuePrev;
+    process.queue = nullptr;
+    process.queuePrev = NO_PROCESS;
+    process.queueNext = NO_PROCESS;
+    --size_;
+}
@@ -0,0 +1,222 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "pageTable.h"
+#include "fileNameTable.h"
+
+constexpr int NO_PROCESS{ 0 };
+
+class PidQueue;
+
+/**
+ * Huge page numbers [first, end) a process asked to back with huge pages.
+ */
+struct HugeRange
+{
+    unsigned long long first;
+    unsigned long long end;
+};
+
+/**
+ * Page-in a process is blocked on with demand paging, a run of base pages or a whole huge page.
+ */
+enum class PageIn : unsigned char
+{
+    None,
+    Base,
+    Huge
+};
+
+struct Process
+{
+    int PID {0};
+    int parentPID {0};
+    bool isWaiting = false;
+    bool isZombie = false;
+    std::vector<int> children;
+    PageTable pageTable;
+    PageTable hugePageTable;        // huge page number -> first frame of its run
+    std::vector<HugeRange> hugeRanges;
+    unsigned long long residentHead {NO_FRAME}; // first frame of the resident set list
+    unsigned long long residentCount {0};
+    unsigned long long sharedCount {0};  // mapped pages owned by another process, shared copy-on-write
+    int core {0};                   // core the process last ran on, or is pinned to
+    int homeNode {0};               // NUMA node NumaPlacement::Preferred puts its pages on
+    bool isReady = false;           // sits in the run queue of its core
+    int priority {0};               // lower runs first, used by the Priority and FairShare schedulers
+    int schedLevel {0};             // MLFQ level
+    unsigned long long vruntime {0};
+    unsigned long long schedKey {0};
+    PidQueue* queue {nullptr};      // FIFO (run queue or disk queue) the process is linked into
+    int queuePrev {NO_PROCESS};
+    int queueNext {NO_PROCESS};
+    FileId ioFile {NO_FILE};        // pending disk read while the process waits in a disk queue
+    unsigned long long ioBlock {0}; // first block and length of the pending read
+    unsigned long long ioSize {0};
+    unsigned long long ioSeq {0};   // arrival number within the disk queue
+    unsigned long long ioQueuedAt {0}; // requests the disk had served when this one was queued
+    int ioDisk {-1};                // disk queue the process waits in, -1 if none
+    PageIn pageIn {PageIn::None};   // the pending read is a page-in from the swap disk
+    bool pageInWrite = false;       // the faulting access was a write
+    unsigned long long faultPage {0};
+    unsigned long long streamPage {0};      // readahead: last page of the stream the detector follows
+    long long streamStride {0};             // pages between its last two faults
+    unsigned long long readAheadWindow {0}; // pages the next readahead loads, 0 until the stride repeats
+};
+
+/**
+ * Dense process table indexed directly by PID. PIDs are handed out in increasing order and never reused,
+ * so slots live in fixed size chunks of consecutive PIDs. A chunk is freed as soon as every PID in it has
+ * been issued and released, and leading freed chunks are dropped from the directory, so memory stays
+ * proportional to the live processes no matter how many were created over the run.
+ */
+class ProcessTable
+{
+    private:
+        static constexpr int CHUNK_BITS = 10;
+        static constexpr int CHUNK_SIZE = 1 << CHUNK_BITS;
+
+        struct Chunk
+        {
+            std::array<Process, CHUNK_SIZE> slots;
+            int live {0};
+        };
+
+        std::deque<std::unique_ptr<Chunk>> chunks_;
+        long long firstChunk_ {0};   // chunk number of chunks_.front()
+        int nextPID_ {0};            // every PID below this one has been issued
+        std::size_t live_ {0};
+
+        Chunk* ChunkOf(int pid) const
+        {
+            long long index = (static_cast<long long>(pid) >> CHUNK_BITS) - firstChunk_;
+            if (pid <= 0 || index < 0 || index >= static_cast<long long>(chunks_.size()))
+                return nullptr;
+            return chunks_[index].get();
+        }
+
+        void Reclaim(long long chunkNumber);
+
+    public:
+        /**
+         * Creates the slot for a new PID. PIDs must be passed in increasing order.
+        */
+        Process& Create(int pid);
+
+        /**
+         * Returns the process with that PID or nullptr if it never existed or has been released.
+        */
+        Process* Find(int pid)
+        {
+            Chunk* chunk = ChunkOf(pid);
+            if (chunk == nullptr || chunk->slots[pid & (CHUNK_SIZE - 1)].PID == 0)
+                return nullptr;
+            return &chunk->slots[pid & (CHUNK_SIZE - 1)];
+        }
+
+        const Process* Find(int pid) const
+        {
+            return const_cast<ProcessTable*>(this)->Find(pid);
+        }
+
+        /**
+         * Drops the process. Its slot becomes a tombstone and the chunk is reclaimed once it is empty.
+        */
+        void Release(int pid);
+
+        std::size_t size() const { return live_; }
+
+        /**
+         * Number of slots currently backed by memory, live or not.
+        */
+        std::size_t Capacity() const;
+
+        int NextPID() const { return nextPID_; }
+
+        /**
+         * Calls visit(process) for every live process in PID order.
+        */
+        template<typename Visitor>
+        void ForEach(Visitor&& visit) const
+        {
+            for (const auto& chunk : chunks_)
+            {
+                if (!chunk)
+                    continue;
+                for (const Process& process : chunk->slots)
+                {
+                    if (process.PID != 0)
+                        visit(process);
+                }
+            }
+        }
+
+        /**
+         * Writes or restores every live process and the PID counter. Queue links are not saved,
+         * the queues relink their processes when they are loaded after the table.
+         * Load throws std::runtime_error for PIDs out of order and flags or enums out of range.
+        */
+        void Save(CheckpointWriter& out) const;
+        void Load(CheckpointReader& in);
+
+        /**
+         * Process a queue being loaded names. Throws std::runtime_error if it isn't live or sits in a queue already.
+        */
+        Process& Queued(int pid);
+};
+
+/**
+ * FIFO of PIDs linked through the Process entries themselves. A process sits in at most one queue
+ * (the ready queue or one disk queue), so pushing, popping and removing a killed process are all O(1).
+ */
+class PidQueue
+{
+    private:
+        int head_ {NO_PROCESS};
+        int tail_ {NO_PROCESS};
+        std::size_t size_ {0};
+
+    public:
+        void PushBack(ProcessTable& table, int pid);
+
+        /**
+         * Unlinks and returns the front PID, or NO_PROCESS if the queue is empty.
+        */
+        int PopFront(ProcessTable& table);
+
+        /**
+         * Unlinks the process from this queue wherever it is.
+        */
+        void Remove(ProcessTable& table, int pid);
+
+        /**
+         * Clears the queue without touching the processes, used before a checkpoint is loaded.
+        */
+        void Reset() { head_ = tail_ = NO_PROCESS; size_ = 0; }
+
+        int front() const { return head_; }
+        bool empty() const { return size_ == 0; }
+        std::size_t size() const { return size_; }
+
+        /**
+         * Calls visit(process) from front to back.
+        */
+        template<typename Visitor>
+        void ForEach(const ProcessTable& table, Visitor&& visit) const
+        {
+            for (int pid = head_; pid != NO_PROCESS;)
+            {
+                const Process& process = *table.Find(pid);
+                int next = process.queueNext;
+                visit(process);
+                pid = next;
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,563 @@
+#include "replacementPolicy.h"
+
+#include <algorithm>
+
+std::unique_ptr<ReplacementPolicy> ReplacementPolicy::Create(ReplacementAlgorithm algorithm, unsigned long long amountOfFrames,
+    unsigned long long workingSetWindow)
+{
+    switch (algorithm)
+    {
+        case ReplacementAlgorithm::FIFO:    return std::make_unique<FIFOPolicy>(amountOfFrames);
+        case ReplacementAlgorithm::Clock:   return std::make_unique<ClockPolicy>(amountOfFrames);
+        case ReplacementAlgorithm::ARC:     return std::make_unique<ARCPolicy>(amountOfFrames);
+        case ReplacementAlgorithm::WSClock:
+            return std::make_unique<WSClockPolicy>(amountOfFrames, workingSetWindow == 0 ? amountOfFrames : workingSetWindow);
+        case ReplacementAlgorithm::LRU: break;
+    }
+    return std::make_unique<LRUPolicy>(amountOfFrames);
+}
+
+FrameList::FrameList(unsigned long long amountOfFrames)
+:prev_(amountOfFrames, NIL),next_(amountOfFrames, NIL),head_{NIL},tail_{NIL},size_{0}
+{
+}
+
+void FrameList::PushBack(unsigned long long frame)
+{
+    prev_[frame] = tail_;
+    next_[frame] = NIL;
+    if (tail_ != NIL)
+        next_[tail_] = frame;
+    else
+        head_ = frame;
+    tail_ = frame;
+    ++size_;
+}
+
+void FrameList::PushFront(unsigned long long frame)
+{
+    prev_[frame] = NIL;
+    next_[frame] = head_;
+    if (head_ != NIL)
+        prev_[head_] = frame;
+    else
+        tail_ = frame;
+    head_ = frame;
+    ++size_;
+}
+
+void FrameList::Remove(unsigned long long frame)
+{
+    if (prev_[frame] != NIL)
+        next_[prev_[frame]] = next_[frame];
+    else
+        head_ = next_[frame];
+
+    if (next_[frame] != NIL)
+        prev_[next_[frame]] = prev_[frame];
+    else
+        tail_ = prev_[frame];
+
+    prev_[frame] = NIL;
+    next_[frame] = NIL;
+    --size_;
+}
+
+void FrameList::Replace(unsigned long long from, unsigned long long to)
+{
+    prev_[to] = prev_[from];
+    next_[to] = next_[from];
+    if (prev_[to] != NIL)
+        next_[prev_[to]] = to;
+    else
+        head_ = to;
+
+    if (next_[to] != NIL)
+        prev_[next_[to]] = to;
+    else
+        tail_ = to;
+
+    prev_[from] = NIL;
+    next_[from] = NIL;
+}
+
+void FrameList::Save(CheckpointWriter& out) const
+{
+    out.Write(head_);
+    out.Write(tail_);
+    out.Write(size_);
+    out.WriteVector(prev_);
+    out.WriteVector(next_);
+}
+
+void FrameList::Load(CheckpointReader& in)
+{
+    unsigned long long frames = next_.size();
+    head_ = in.Read<unsigned long long>();
+    tail_ = in.Read<unsigned long long>();
+    size_ = in.Read<unsigned long long>();
+    in.ReadVector(prev_);
+    in.ReadVector(next_);
+
+    // One chain of size_ frames from head to tail with matching back links, every other frame unlinked
+    CheckCheckpoint(prev_.size() == frames && next_.size() == frames && size_ <= frames);
+    unsigned long long linked = 0;
+    unsigned long long last = NIL;
+    for (unsigned long long frame = head_; frame != NIL; frame = next_[frame])
+    {
+        CheckCheckpoint(frame < frames && linked < size_ && prev_[frame] == last);
+        last = frame;
+        ++linked;
+    }
+    unsigned long long links = size_ == 0 ? 0 : size_ - 1;
+    CheckCheckpoint(linked == size_ && tail_ == last
+        && std::count_if(prev_.begin(), prev_.end(), [](unsigned long long frame) { return frame != NIL; }) == links
+        && std::count_if(next_.begin(), next_.end(), [](unsigned long long frame) { return frame != NIL; }) == links);
+}
+
+LRUPolicy::LRUPolicy(unsigned long long amountOfFrames)
+:order_(amountOfFrames)
+{
+}
+
+void LRUPolicy::Insert(unsigned long long frame, const PageKey& page)
+{
+    order_.PushBack(frame);
+}
+
+void LRUPolicy::Touch(unsigned long long frame)
+{
+    if (order_.Back() == frame)
+        return;
+    order_.Remove(frame);
+    order_.PushBack(frame);
+}
+
+void LRUPolicy::Demote(unsigned long long frame)
+{
+    order_.Remove(frame);
+    order_.PushFront(frame);
+}
+
+void LRUPolicy::Remove(unsigned long long frame)
+{
+    if (order_.Contains(frame))
+        order_.Remove(frame);
+}
+
+void LRUPolicy::Move(unsigned long long from, unsigned long long to)
+{
+    if (order_.Contains(from))
+        order_.Replace(from, to);
+}
+
+unsigned long long LRUPolicy::Victim(const PageKey& page)
+{
+    unsigned long long frame = order_.Front();
+    Touch(frame);
+    return frame;
+}
+
+unsigned long long LRUPolicy::Evict()
+{
+    unsigned long long frame = order_.Front();
+    order_.Remove(frame);
+    return frame;
+}
+
+void LRUPolicy::Save(CheckpointWriter& out) const
+{
+    order_.Save(out);
+}
+
+void LRUPolicy::Load(CheckpointReader& in)
+{
+    order_.Load(in);
+}
+
+FIFOPolicy::FIFOPolicy(unsigned long long amountOfFrames)
+:order_(amountOfFrames)
+{
+}
+
+void FIFOPolicy::Insert(unsigned long long frame, const PageKey& page)
+{
+    order_.PushBack(frame);
+}
+
+void FIFOPolicy::Demote(unsigned long long frame)
+{
+    order_.Remove(frame);
+    order_.PushFront(frame);
+}
+
+void FIFOPolicy::Remove(unsigned long long frame)
+{
+    if (order_.Contains(frame))
+        order_.Remove(frame);
+}
+
+void FIFOPolicy::Move(unsigned long long from, unsigned long long to)
+{
+    if (order_.Contains(from))
+        order_.Replace(from, to);
+}
+
+unsigned long long FIFOPolicy::Victim(const PageKey& page)
+{
+    unsigned long long frame = order_.Front();
+    order_.Remove(frame);
+    order_.PushBack(frame);
+    return frame;
+}
+
+unsigned long long FIFOPolicy::Evict()
+{
+    unsigned long long frame = order_.Front();
+    order_.Remove(frame);
+    return frame;
+}
+
+void FIFOPolicy::Save(CheckpointWriter& out) const
+{
+    order_.Save(out);
+}
+
+void FIFOPolicy::Load(CheckpointReader& in)
+{
+    order_.Load(in);
+}
+
+ClockPolicy::ClockPolicy(unsigned long long amountOfFrames)
+:state_(amountOfFrames, Absent),hand_{0}
+{
+}
+
+void ClockPolicy::Insert(unsigned long long frame, const PageKey& page)
+{
+    state_[frame] = Referenced;
+}
+
+void ClockPolicy::Move(unsigned long long from, unsigned long long to)
+{
+    state_[to] = state_[from];
+    state_[from] = Absent;
+}
+
+unsigned long long ClockPolicy::Victim(const PageKey& page)
+{
+    unsigned long long frame = Evict();
+    Insert(frame, page);
+    return frame;
+}
+
+unsigned long long ClockPolicy::Evict()
+{
+    while (state_[hand_] != Resident)
+    {
+        if (state_[hand_] == Referenced)
+            state_[hand_] = Resident;
+        Advance();
+    }
+    unsigned long long frame = hand_;
+    state_[frame] = Absent;
+    Advance();
+    return frame;
+}
+
+void ClockPolicy::Save(CheckpointWriter& out) const
+{
+    out.Write(hand_);
+    out.WriteVector(state_);
+}
+
+void ClockPolicy::Load(CheckpointReader& in)
+{
+    unsigned long long frames = state_.size();
+    hand_ = in.Read<unsigned long long>();
+    in.ReadVector(state_);
+    CheckCheckpoint(state_.size() == frames && (frames == 0 ? hand_ == 0 : hand_ < frames)
+        && std::all_of(state_.begin(), state_.end(), [](unsigned char state) { return state <= Referenced; }));
+}
+
+WSClockPolicy::WSClockPolicy(unsigned long long amountOfFrames, unsigned long long window)
+:ClockPolicy(amountOfFrames),lastUse_(amountOfFrames, 0),window_{window},now_{0}
+{
+}
+
+void WSClockPolicy::Insert(unsigned long long frame, const PageKey& page)
+{
+    state_[frame] = Referenced;
+    lastUse_[frame] = now_++;
+}
+
+void WSClockPolicy::Demote(unsigned long long frame)
+{
+    // As old as a page can be, so it is the first one out of the working set
+    state_[frame] = Resident;
+    lastUse_[frame] = 0;
+}
+
+void WSClockPolicy::Move(unsigned long long from, unsigned long long to)
+{
+    ClockPolicy::Move(from, to);
+    lastUse_[to] = lastUse_[from];
+}
+
+unsigned long long WSClockPolicy::Victim(const PageKey& page)
+{
+    unsigned long long frame = Evict();
+    Insert(frame, page);
+    return frame;
+}
+
+unsigned long long WSClockPolicy::Evict()
+{
+    unsigned long long oldest = FrameList::NIL;
+    unsigned int young = 0;
+    unsigned long long frame;
+    while (true)
+    {
+        if (state_[hand_] == Referenced)
+        {
+            state_[hand_] = Resident;
+            lastUse_[hand_] = now_;
+        }
+        else if (state_[hand_] == Resident)
+        {
+            if (now_ - lastUse_[hand_] > window_)
+            {
+                frame = hand_;
+                Advance();
+                break;
+            }
+            if (oldest == FrameList::NIL || lastUse_[hand_] < lastUse_[oldest])
+                oldest = hand_;
+            if (++young == SCAN_LIMIT)
+            {
+                frame = oldest;
+                Advance();
+                break;
+            }
+        }
+        Advance();
+    }
+    state_[frame] = Absent;
+    return frame;
+}
+
+void WSClockPolicy::Save(CheckpointWriter& out) const
+{
+    ClockPolicy::Save(out);
+    out.Write(window_);
+    out.Write(now_);
+    out.WriteVector(lastUse_);
+}
+
+void WSClockPolicy::Load(CheckpointReader& in)
+{
+    ClockPolicy::Load(in);
+    window_ = in.Read<unsigned long long>();
+    now_ = in.Read<unsigned long long>();
+    in.ReadVector(lastUse_);
+    CheckCheckpoint(lastUse_.size() == state_.size());
+}
+
+ARCPolicy::ARCPolicy(unsigned long long amountOfFrames)
+:capacity_{amountOfFrames},target_{0},t1_(amountOfFrames),t2_(amountOfFrames),pages_(amountOfFrames),
+b1_(amountOfFrames),b2_(amountOfFrames),ghostPages_(amountOfFrames)
+{
+    freeGhosts_.reserve(amountOfFrames);
+    for (unsigned long long slot = amountOfFrames; slot > 0; --slot)
+        freeGhosts_.push_back(slot - 1);
+}
+
+ARCPolicy::GhostList ARCPolicy::TakeGhost(const PageKey& page)
+{
+    auto found = ghosts_.find(page);
+    if (found == ghosts_.end())
+        return NoGhost;
+
+    unsigned long long slot = found->second;
+    ghosts_.erase(found);
+    freeGhosts_.push_back(slot);
+    if (b1_.Contains(slot))
+    {
+        target_ = std::min(capacity_, target_ + std::max<unsigned long long>(1, b2_.size() / b1_.size()));
+        b1_.Remove(slot);
+        return InB1;
+    }
+    unsigned long long step = std::max<unsigned long long>(1, b1_.size() / b2_.size());
+    target_ = target_ > step ? target_ - step : 0;
+    b2_.Remove(slot);
+    return InB2;
+}
+
+void ARCPolicy::DropGhost(FrameList& list)
+{
+    unsigned long long slot = list.Front();
+    list.Remove(slot);
+    ghosts_.erase(ghostPages_[slot]);
+    freeGhosts_.push_back(slot);
+}
+
+void ARCPolicy::PushGhost(FrameList& list, const PageKey& page)
+{
+    unsigned long long slot = freeGhosts_.back();
+    freeGhosts_.pop_back();
+    ghostPages_[slot] = page;
+    ghosts_[page] = slot;
+    list.PushBack(slot);
+}
+
+unsigned long long ARCPolicy::Replace(bool hitInB2)
+{
+    unsigned long long frame;
+    if (!t1_.empty() && (t1_.size() > target_ || (hitInB2 && t1_.size() == target_) || t2_.empty()))
+    {
+        frame = t1_.Front();
+        t1_.Remove(frame);
+        PushGhost(b1_, pages_[frame]);
+    }
+    else
+    {
+        frame = t2_.Front();
+        t2_.Remove(frame);
+        PushGhost(b2_, pages_[frame]);
+    }
+    return frame;
+}
+
+void ARCPolicy::Place(unsigned long long frame, const PageKey& page, GhostList ghost)
+{
+    pages_[frame] = page;
+    if (ghost == NoGhost)
+        t1_.PushBack(frame);
+    else
+        t2_.PushBack(frame);
+}
+
+void ARCPolicy::Insert(unsigned long long frame, const PageKey& page)
+{
+    GhostList ghost = TakeGhost(page);
+    if (ghost == NoGhost && t1_.size() + b1_.size() >= capacity_ && !b1_.empty())
+        DropGhost(b1_);
+    Place(frame, page, ghost);
+}
+
+void ARCPolicy::Touch(unsigned long long frame)
+{
+    if (t1_.Contains(frame))
+    {
+        t1_.Remove(frame);
+        t2_.PushBack(frame);
+    }
+    else if (t2_.Back() != frame)
+    {
+        t2_.Remove(frame);
+        t2_.PushBack(frame);
+    }
+}
+
+void ARCPolicy::Demote(unsigned long long frame)
+{
+    // Not used yet, so it belongs at the LRU end of T1 even if it came back from a ghost list
+    if (t1_.Contains(frame))
+        t1_.Remove(frame);
+    else
+        t2_.Remove(frame);
+    t1_.PushFront(frame);
+}
+
+void ARCPolicy::Remove(unsigned long long frame)
+{
+    if (t1_.Contains(frame))
+        t1_.Remove(frame);
+    else if (t2_.Contains(frame))
+        t2_.Remove(frame);
+}
+
+void ARCPolicy::Move(unsigned long long from, unsigned long long to)
+{
+    if (t1_.Contains(from))
+        t1_.Replace(from, to);
+    else if (t2_.Contains(from))
+        t2_.Replace(from, to);
+    pages_[to] = pages_[from];
+}
+
+unsigned long long ARCPolicy::Victim(const PageKey& page)
+{
+    GhostList ghost = TakeGhost(page);
+    unsigned long long frame;
+    if (ghost == NoGhost && t1_.size() + b1_.size() >= capacity_ && b1_.empty())
+    {
+        // T1 fills the whole cache, its LRU page goes without leaving a ghost
+        frame = t1_.Front();
+        t1_.Remove(frame);
+    }
+    else
+    {
+        if (ghost == NoGhost && t1_.size() + b1_.size() >= capacity_)
+            DropGhost(b1_);
+        else if (ghost == NoGhost && b1_.size() + b2_.size() >= capacity_)
+            DropGhost(b2_.empty() ? b1_ : b2_);
+        frame = Replace(ghost == InB2);
+    }
+    Place(frame, page, ghost);
+    return frame;
+}
+
+unsigned long long ARCPolicy::Evict()
+{
+    // The choice of a replacement without a ghost hit, but the frame is freed and leaves no ghost to adapt on
+    FrameList& list = !t1_.empty() && (t1_.size() > target_ || t2_.empty()) ? t1_ : t2_;
+    unsigned long long frame = list.Front();
+    list.Remove(frame);
+    return frame;
+}
+
+void ARCPolicy::Save(CheckpointWriter& out) const
+{
+    out.Write(capacity_);
+    out.Write(target_);
+    t1_.Save(out);
+    t2_.Save(out);
+    out.WriteVector(pages_);
+    b1_.Save(out);
+    b2_.Save(out);
+    out.WriteVector(ghostPages_);
+    out.WriteVector(freeGhosts_);
+}
+
+void ARCPolicy::Load(CheckpointReader& in)
+{
+    unsigned long long capacity = capacity_;
+    capacity_ = in.Read<unsigned long long>();
+    target_ = in.Read<unsigned long long>();
+    t1_.Load(in);
+    t2_.Load(in);
+    in.ReadVector(pages_);
+    b1_.Load(in);
+    b2_.Load(in);
+    in.ReadVector(ghostPages_);
+    in.ReadVector(freeGhosts_);
+    CheckCheckpoint(capacity_ == capacity && target_ <= capacity_ && pages_.size() == capacity_ && ghostPages_.size() == capacity_
+        && freeGhosts_.size() + b1_.size() + b2_.size() == capacity_);
+
+    // Every frame in at most one of T1 and T2, every ghost slot in exactly one of B1, B2 and the free slots
+    std::vector<unsigned char> free(capacity_, 0);
+    for (unsigned long long slot : freeGhosts_)
+    {
+        CheckCheckpoint(slot < capacity_ && !free[slot]);
+        free[slot] = 1;
+    }
+    ghosts_.clear();
+    for (unsigned long long slot = 0; slot < capacity_; ++slot)
+    {
+        CheckCheckpoint(!(t1_.Contains(slot) && t2_.Contains(slot)) && !(b1_.Contains(slot) && b2_.Contains(slot))
+            && !(free[slot] && (b1_.Contains(slot) || b2_.Contains(slot))));
+        if (b1_.Contains(slot) || b2_.Contains(slot))
+            CheckCheckpoint(ghosts_.emplace(ghostPages_[slot], slot).second);
+    }
+}
@@ -0,0 +1,307 @@
+#ifndef REPLACEMENT_POLICY_H
+#define REPLACEMENT_POLICY_H
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "checkpoint.h"
+
+/**
+ * Page replacement algorithms. Victim selection is O(1) amortized for all of them.
+ * LRU:     exact least recently used (the original SimOS behaviour).
+ * FIFO:    the page loaded first goes first, accesses don't matter.
+ * Clock:   second chance. A hand sweeps the frames and clears reference bits, the first frame found
+ *          unreferenced is replaced.
+ * ARC:     adaptive replacement cache. Balances recency against frequency with two resident lists and
+ *          two ghost lists of recently evicted pages, tuned by the ghost hits.
+ * WSClock: working set clock. Like Clock, but a page used within the last window memory references
+ *          is part of the working set and is skipped.
+ */
+enum class ReplacementAlgorithm
+{
+    LRU,
+    FIFO,
+    Clock,
+    ARC,
+    WSClock
+};
+
+/**
+ * Identifies the page loaded into a frame, for policies that remember evicted pages.
+ */
+struct PageKey
+{
+    unsigned long long page;
+    int PID;
+
+    bool operator==(const PageKey& other) const { return page == other.page && PID == other.PID; }
+};
+
+struct PageKeyHash
+{
+    std::size_t operator()(const PageKey& key) const
+    {
+        return static_cast<std::size_t>((key.page * 0x9E3779B97F4A7C15ULL) ^ static_cast<unsigned int>(key.PID));
+    }
+};
+
+/**
+ * Decides which resident frame gets replaced when RAM is full.
+ * SimOS tells the policy about every frame that becomes resident, is accessed again or is released,
+ * and asks it for a victim only when there is no free frame left.
+ */
+class ReplacementPolicy
+{
+    public:
+        virtual ~ReplacementPolicy() = default;
+
+        /**
+         * A free frame was just loaded with a page.
+        */
+        virtual void Insert(unsigned long long frame, const PageKey& page) = 0;
+
+        /**
+         * A resident frame was accessed again.
+        */
+        virtual void Touch(unsigned long long frame) = 0;
+
+        /**
+         * A frame that was just loaded speculatively, by readahead, goes where it is replaced early, so a wrong
+         * guess doesn't push out pages that are in use.
+        */
+        virtual void Demote(unsigned long long frame) = 0;
+
+        /**
+         * A resident frame was released and is no longer a replacement candidate.
+        */
+        virtual void Remove(unsigned long long frame) = 0;
+
+        /**
+         * The page in frame from was migrated to the free frame to, which takes over its place in the policy.
+        */
+        virtual void Move(unsigned long long from, unsigned long long to) = 0;
+
+        /**
+         * Returns the frame that should be replaced to load page. The frame stays tracked by the policy,
+         * which treats it as just loaded with page from then on.
+        */
+        virtual unsigned long long Victim(const PageKey& page) = 0;
+
+        /**
+         * Returns the frame that should be replaced and stops tracking it, for a frame that is freed instead of
+         * reused. No page is admitted, so policies that remember evicted pages don't look one up.
+        */
+        virtual unsigned long long Evict() = 0;
+
+        /**
+         * True while the frame is a replacement candidate, from Insert until Remove or Evict.
+        */
+        virtual bool Tracks(unsigned long long frame) const = 0;
+
+        /**
+         * Writes or restores the complete policy state for a checkpoint. Load expects a policy created for as
+         * many frames as the saved one and throws std::runtime_error if the state doesn't fit or contradicts itself.
+        */
+        virtual void Save(CheckpointWriter& out) const = 0;
+        virtual void Load(CheckpointReader& in) = 0;
+
+        /**
+         * workingSetWindow is only used by WSClock, 0 means the number of frames.
+        */
+        static std::unique_ptr<ReplacementPolicy> Create(ReplacementAlgorithm algorithm, unsigned long long amountOfFrames,
+            unsigned long long workingSetWindow = 0);
+};
+
+/**
+ * Intrusive doubly linked list threaded through the frame numbers, front to back.
+ * Every operation is O(1).
+ */
+class FrameList
+{
+    private:
+        std::vector<unsigned long long> prev_;
+        std::vector<unsigned long long> next_;
+        unsigned long long head_;
+        unsigned long long tail_;
+        unsigned long long size_;
+
+    public:
+        static constexpr unsigned long long NIL = ~0ULL;
+
+        explicit FrameList(unsigned long long amountOfFrames);
+
+        bool Contains(unsigned long long frame) const { return prev_[frame] != NIL || head_ == frame; }
+        unsigned long long Front() const { return head_; }
+        unsigned long long Back() const { return tail_; }
+        unsigned long long size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        void PushBack(unsigned long long frame);
+        void PushFront(unsigned long long frame);
+        void Remove(unsigned long long frame);
+
+        /**
+         * Puts frame to, which must not be in the list, in the position of frame from.
+        */
+        void Replace(unsigned long long from, unsigned long long to);
+
+        void Save(CheckpointWriter& out) const;
+        void Load(CheckpointReader& in);
+};
+
+/**
+ * Exact LRU. Front of the list is the least recently used frame.
+ */
+class LRUPolicy : public ReplacementPolicy
+{
+    private:
+        FrameList order_;
+
+    public:
+        explicit LRUPolicy(unsigned long long amountOfFrames);
+
+        void Insert(unsigned long long frame, const PageKey& page) override;
+        void Touch(unsigned long long frame) override;
+        void Demote(unsigned long long frame) override;
+        void Remove(unsigned long long frame) override;
+        void Move(unsigned long long from, unsigned long long to) override;
+        unsigned long long Victim(const PageKey& page) override;
+        unsigned long long Evict() override;
+        bool Tracks(unsigned long long frame) const override { return order_.Contains(frame); }
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+/**
+ * Frames in load order, front is the oldest.
+ */
+class FIFOPolicy : public ReplacementPolicy
+{
+    private:
+        FrameList order_;
+
+    public:
+        explicit FIFOPolicy(unsigned long long amountOfFrames);
+
+        void Insert(unsigned long long frame, const PageKey& page) override;
+        void Touch(unsigned long long frame) override {}
+        void Demote(unsigned long long frame) override;
+        void Remove(unsigned long long frame) override;
+        void Move(unsigned long long from, unsigned long long to) override;
+        unsigned long long Victim(const PageKey& page) override;
+        unsigned long long Evict() override;
+        bool Tracks(unsigned long long frame) const override { return order_.Contains(frame); }
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+/**
+ * Second chance with one reference bit per frame. A hit only sets the bit, so hits cost a single store.
+ * Every bit the hand clears was set by an access, which makes victim selection O(1) amortized.
+ */
+class ClockPolicy : public ReplacementPolicy
+{
+    protected:
+        enum FrameState : unsigned char { Absent, Resident, Referenced };
+
+        std::vector<unsigned char> state_;
+        unsigned long long hand_;
+
+        void Advance() { hand_ = hand_ + 1 == state_.size() ? 0 : hand_ + 1; }
+
+    public:
+        explicit ClockPolicy(unsigned long long amountOfFrames);
+
+        void Insert(unsigned long long frame, const PageKey& page) override;
+        void Touch(unsigned long long frame) override { state_[frame] = Referenced; }
+        void Demote(unsigned long long frame) override { state_[frame] = Resident; }
+        void Remove(unsigned long long frame) override { state_[frame] = Absent; }
+        void Move(unsigned long long from, unsigned long long to) override;
+        unsigned long long Victim(const PageKey& page) override;
+        unsigned long long Evict() override;
+        bool Tracks(unsigned long long frame) const override { return state_[frame] != Absent; }
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+/**
+ * WSClock with virtual time counted in memory references. The hand stamps a frame with the current time
+ * when it clears its reference bit, and replaces the first unreferenced frame older than the window.
+ * When SCAN_LIMIT frames in a row are still in the working set the oldest of them is replaced instead,
+ * which bounds the work per fault when the working set doesn't fit in RAM.
+ */
+class WSClockPolicy : public ClockPolicy
+{
+    private:
+        static constexpr unsigned int SCAN_LIMIT = 32;
+
+        std::vector<unsigned long long> lastUse_;
+        unsigned long long window_;
+        unsigned long long now_;
+
+    public:
+        WSClockPolicy(unsigned long long amountOfFrames, unsigned long long window);
+
+        void Insert(unsigned long long frame, const PageKey& page) override;
+        void Touch(unsigned long long frame) override { state_[frame] = Referenced; ++now_; }
+        void Demote(unsigned long long frame) override;
+        void Move(unsigned long long from, unsigned long long to) override;
+        unsigned long long Victim(const PageKey& page) override;
+        unsigned long long Evict() override;
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+/**
+ * ARC (Megiddo and Modha). T1 holds pages used once recently, T2 pages used at least twice, B1 and B2
+ * the pages last evicted from each. The target size p of T1 grows on B1 hits and shrinks on B2 hits.
+ * Ghost entries live in a fixed pool of amountOfFrames slots indexed by a hash map.
+ */
+class ARCPolicy : public ReplacementPolicy
+{
+    private:
+        enum GhostList : unsigned char { NoGhost, InB1, InB2 };
+
+        unsigned long long capacity_;
+        unsigned long long target_;               // p, the target size of T1
+        FrameList t1_;
+        FrameList t2_;
+        std::vector<PageKey> pages_;              // page held by each resident frame
+
+        FrameList b1_;                            // over ghost slots
+        FrameList b2_;
+        std::vector<PageKey> ghostPages_;
+        std::vector<unsigned long long> freeGhosts_;
+        std::unordered_map<PageKey, unsigned long long, PageKeyHash> ghosts_;
+
+        /**
+         * Adapts the target on a ghost hit and drops the ghost. Returns the list it was found in.
+        */
+        GhostList TakeGhost(const PageKey& page);
+        void DropGhost(FrameList& list);
+        void PushGhost(FrameList& list, const PageKey& page);
+
+        /**
+         * Evicts the LRU frame of T1 or T2 into its ghost list and returns it.
+        */
+        unsigned long long Replace(bool hitInB2);
+        void Place(unsigned long long frame, const PageKey& page, GhostList ghost);
+
+    public:
+        explicit ARCPolicy(unsigned long long amountOfFrames);
+
+        void Insert(unsigned long long frame, const PageKey& page) override;
+        void Touch(unsigned long long frame) override;
+        void Demote(unsigned long long frame) override;
+        void Remove(unsigned long long frame) override;
+        void Move(unsigned long long from, unsigned long long to) override;
+        unsigned long long Victim(const PageKey& page) override;
+        unsigned long long Evict() override;
+        bool Tracks(unsigned long long frame) const override { return t1_.Contains(frame) || t2_.Contains(frame); }
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+#endif
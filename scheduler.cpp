@@ -0,0 +1,287 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+std::unique_ptr<Scheduler> Scheduler::Create(SchedulingPolicy policy, ProcessTable& processes)
+{
+    switch (policy)
+    {
+        case SchedulingPolicy::Priority:  return std::make_unique<PriorityScheduler>(processes);
+        case SchedulingPolicy::MLFQ:      return std::make_unique<MLFQScheduler>(processes);
+        case SchedulingPolicy::FairShare: return std::make_unique<FairShareScheduler>(processes);
+        case SchedulingPolicy::RoundRobin: break;
+    }
+    return std::make_unique<RoundRobinScheduler>(processes);
+}
+
+std::vector<int> Scheduler::QueuedPIDs() const
+{
+    std::vector<int> pids;
+    pids.reserve(size());
+    ForEach([&pids](int pid) {
+        pids.push_back(pid);
+    });
+    return pids;
+}
+
+void RoundRobinScheduler::Enqueue(Process& process, ReadyReason reason)
+{
+    queue_.PushBack(processes_, process.PID);
+}
+
+int RoundRobinScheduler::Dequeue()
+{
+    return queue_.PopFront(processes_);
+}
+
+void RoundRobinScheduler::Remove(Process& process)
+{
+    queue_.Remove(processes_, process.PID);
+}
+
+void RoundRobinScheduler::ForEach(const std::function<void(int)>& visit) const
+{
+    queue_.ForEach(processes_, [&visit](const Process& process) {
+        visit(process.PID);
+    });
+}
+
+void PriorityScheduler::Enqueue(Process& process, ReadyReason reason)
+{
+    process.schedKey = arrivals_++;
+    queue_.emplace(process.priority, process.schedKey, process.PID);
+}
+
+int PriorityScheduler::Dequeue()
+{
+    if (queue_.empty())
+        return NO_PROCESS;
+    int pid = std::get<2>(*queue_.begin());
+    queue_.erase(queue_.begin());
+    return pid;
+}
+
+void PriorityScheduler::Remove(Process& process)
+{
+    queue_.erase(std::make_tuple(process.priority, process.schedKey, process.PID));
+}
+
+void PriorityScheduler::ForEach(const std::function<void(int)>& visit) const
+{
+    for (const auto& entry : queue_)
+        visit(std::get<2>(entry));
+}
+
+void PriorityScheduler::SetPriority(Process& process, int priority)
+{
+    if (queue_.erase(std::make_tuple(process.priority, process.schedKey, process.PID)) == 0)
+    {
+        process.priority = priority;
+        return;
+    }
+    process.priority = priority;
+    queue_.emplace(process.priority, process.schedKey, process.PID);
+}
+
+MLFQScheduler::MLFQScheduler(ProcessTable& processes)
+:Scheduler(processes),levels_(LEVELS)
+{
+}
+
+void MLFQScheduler::Enqueue(Process& process, ReadyReason reason)
+{
+    if (reason == ReadyReason::New)
+        process.schedLevel = 0;
+    else if (reason == ReadyReason::Preempted && process.schedLevel < LEVELS - 1)
+        ++process.schedLevel;
+    levels_[process.schedLevel].PushBack(processes_, process.PID);
+    ++size_;
+}
+
+int MLFQScheduler::Dequeue()
+{
+    if (size_ == 0)
+        return NO_PROCESS;
+    if (++dequeuesSinceBoost_ >= std::max(BOOST_INTERVAL, size_))
+        Boost();
+    for (auto& level : levels_)
+    {
+        if (!level.empty())
+        {
+            --size_;
+            return level.PopFront(processes_);
+        }
+    }
+    return NO_PROCESS;
+}
+
+void MLFQScheduler::Remove(Process& process)
+{
+    std::size_t before = levels_[process.schedLevel].size();
+    levels_[process.schedLevel].Remove(processes_, process.PID);
+    size_ -= before - levels_[process.schedLevel].size();
+}
+
+void MLFQScheduler::Boost()
+{
+    dequeuesSinceBoost_ = 0;
+    for (int level = 1; level < LEVELS; ++level)
+    {
+        for (int pid = levels_[level].PopFront(processes_); pid != NO_PROCESS; pid = levels_[level].PopFront(processes_))
+        {
+            processes_.Find(pid)->schedLevel = 0;
+            levels_[0].PushBack(processes_, pid);
+        }
+    }
+}
+
+void MLFQScheduler::ForEach(const std::function<void(int)>& visit) const
+{
+    for (const auto& level : levels_)
+    {
+        level.ForEach(processes_, [&visit](const Process& process) {
+            visit(process.PID);
+        });
+    }
+}
+
+unsigned long long FairShareScheduler::Weight(int priority)
+{
+    // Same shape as the Linux nice table: every priority step changes the weight by 25%
+    // capped where a time slice stops advancing virtual runtime, so extreme priorities stay finite
+    double weight = 1024.0 * std::pow(1.25, -priority);
+    if (weight > QUANTUM * 1024.0)
+        return QUANTUM * 1024;
+    return weight < 1.0 ? 1 : static_cast<unsigned long long>(weight);
+}
+
+void FairShareScheduler::Enqueue(Process& process, ReadyReason reason)
+{
+    if (reason == ReadyReason::Preempted)
+    {
+        process.vruntime += QUANTUM * 1024 / Weight(process.priority);
+    }
+    else if (reason == ReadyReason::New)
+    {
+        process.vruntime = std::max(process.vruntime, minVruntime_);
+    }
+    else
+    {
+        // Sleepers get at most one quantum of credit
+        unsigned long long floor = minVruntime_ > QUANTUM ? minVruntime_ - QUANTUM : 0;
+        process.vruntime = std::max(process.vruntime, floor);
+    }
+    process.schedKey = arrivals_++;
+    queue_.emplace(process.vruntime, process.schedKey, process.PID);
+}
+
+int FairShareScheduler::Dequeue()
+{
+    if (queue_.empty())
+        return NO_PROCESS;
+    auto first = queue_.begin();
+    minVruntime_ = std::max(minVruntime_, std::get<0>(*first));
+    int pid = std::get<2>(*first);
+    queue_.erase(first);
+    return pid;
+}
+
+void FairShareScheduler::Remove(Process& process)
+{
+    queue_.erase(std::make_tuple(process.vruntime, process.schedKey, process.PID));
+}
+
+void FairShareScheduler::ForEach(const std::function<void(int)>& visit) const
+{
+    for (const auto& entry : queue_)
+        visit(std::get<2>(entry));
+}
+
+void RoundRobinScheduler::Save(CheckpointWriter& out) const
+{
+    out.WriteVector(QueuedPIDs());
+}
+
+void RoundRobinScheduler::Load(CheckpointReader& in)
+{
+    std::vector<int> pids;
+    in.ReadVector(pids);
+    queue_.Reset();
+    for (int pid : pids)
+        queue_.PushBack(processes_, processes_.Queued(pid).PID);
+}
+
+void PriorityScheduler::Save(CheckpointWriter& out) const
+{
+    out.Write(arrivals_);
+    out.WriteVector(QueuedPIDs());
+}
+
+void PriorityScheduler::Load(CheckpointReader& in)
+{
+    arrivals_ = in.Read<unsigned long long>();
+    std::vector<int> pids;
+    in.ReadVector(pids);
+    queue_.clear();
+    for (int pid : pids)
+    {
+        const Process& process = processes_.Queued(pid);
+        queue_.emplace_hint(queue_.end(), process.priority, process.schedKey, pid);
+    }
+    CheckCheckpoint(queue_.size() == pids.size());
+}
+
+void MLFQScheduler::Save(CheckpointWriter& out) const
+{
+    out.Write<std::uint64_t>(dequeuesSinceBoost_);
+    for (const auto& level : levels_)
+    {
+        std::vector<int> pids;
+        level.ForEach(processes_, [&pids](const Process& process) {
+            pids.push_back(process.PID);
+        });
+        out.WriteVector(pids);
+    }
+}
+
+void MLFQScheduler::Load(CheckpointReader& in)
+{
+    dequeuesSinceBoost_ = in.Read<std::uint64_t>();
+    size_ = 0;
+    std::vector<int> pids;
+    for (auto& level : levels_)
+    {
+        in.ReadVector(pids);
+        level.Reset();
+        for (int pid : pids)
+        {
+            Process& process = processes_.Queued(pid);
+            CheckCheckpoint(process.schedLevel == &level - levels_.data());
+            level.PushBack(processes_, pid);
+        }
+        size_ += pids.size();
+    }
+}
+
+void FairShareScheduler::Save(CheckpointWriter& out) const
+{
+    out.Write(arrivals_);
+    out.Write(minVruntime_);
+    out.WriteVector(QueuedPIDs());
+}
+
+void FairShareScheduler::Load(CheckpointReader& in)
+{
+    arrivals_ = in.Read<unsigned long long>();
+    minVruntime_ = in.Read<unsigned long long>();
+    std::vector<int> pids;
+    in.ReadVector(pids);
+    queue_.clear();
+    for (int pid : pids)
+    {
+        const Process& process = processes_.Queued(pid);
+        queue_.emplace_hint(queue_.end(), process.vruntime, process.schedKey, pid);
+    }
+    CheckCheckpoint(queue_.size() == pids.size());
+}
@@ -0,0 +1,183 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "processTable.h"
+#include "checkpoint.h"
+
+/**
+ * CPU scheduling policies for the run queue of a core.
+ * RoundRobin: FIFO, a preempted process goes to the back (the original SimOS behaviour).
+ * Priority:   lowest priority value runs first, FIFO among equal priorities.
+ * MLFQ:       multilevel feedback queue. Processes start at the top level, drop a level every time they
+ *             use up a time slice and are periodically boosted back to the top so nothing starves.
+ * FairShare:  CFS style. The process with the smallest virtual runtime runs first, and a time slice
+ *             advances virtual runtime more slowly for processes with a better (lower) priority value.
+ */
+enum class SchedulingPolicy
+{
+    RoundRobin,
+    Priority,
+    MLFQ,
+    FairShare
+};
+
+/**
+ * Why a process is entering the run queue.
+ */
+enum class ReadyReason
+{
+    New,        // just created or forked
+    Preempted,  // its time slice ran out
+    Woken       // disk read finished or its wait is over
+};
+
+/**
+ * Run queue of one core. SimOS only ever puts a process into one run queue at a time, and tells the
+ * queue about every process that leaves it outside of Dequeue (killed, or its priority changed).
+ */
+class Scheduler
+{
+    protected:
+        ProcessTable& processes_;
+
+    public:
+        explicit Scheduler(ProcessTable& processes) : processes_(processes) {}
+        virtual ~Scheduler() = default;
+
+        virtual void Enqueue(Process& process, ReadyReason reason) = 0;
+
+        /**
+         * Removes and returns the process that should run next, or NO_PROCESS if the queue is empty.
+        */
+        virtual int Dequeue() = 0;
+
+        virtual void Remove(Process& process) = 0;
+        virtual std::size_t size() const = 0;
+        bool empty() const { return size() == 0; }
+
+        /**
+         * Changes the priority of a process that may be sitting in this queue.
+        */
+        virtual void SetPriority(Process& process, int priority) { process.priority = priority; }
+
+        /**
+         * Calls visit(pid) in the order the processes would be dequeued.
+        */
+        virtual void ForEach(const std::function<void(int)>& visit) const = 0;
+
+        /**
+         * Writes or restores the queue for a checkpoint. Processes are saved as PIDs in queue order and
+         * relinked from their own fields, so the process table has to be loaded first. Load throws
+         * std::runtime_error for a PID that isn't in the table or is queued twice.
+        */
+        virtual void Save(CheckpointWriter& out) const = 0;
+        virtual void Load(CheckpointReader& in) = 0;
+
+        static std::unique_ptr<Scheduler> Create(SchedulingPolicy policy, ProcessTable& processes);
+
+    protected:
+        std::vector<int> QueuedPIDs() const;
+};
+
+class RoundRobinScheduler : public Scheduler
+{
+    private:
+        PidQueue queue_;
+
+    public:
+        using Scheduler::Scheduler;
+
+        void Enqueue(Process& process, ReadyReason reason) override;
+        int Dequeue() override;
+        void Remove(Process& process) override;
+        std::size_t size() const override { return queue_.size(); }
+        void ForEach(const std::function<void(int)>& visit) const override;
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+/**
+ * Ordered by (priority, arrival). Enqueue, Dequeue and Remove are O(log n).
+ */
+class PriorityScheduler : public Scheduler
+{
+    private:
+        std::set<std::tuple<int, unsigned long long, int>> queue_;
+        unsigned long long arrivals_ {0};
+
+    public:
+        using Scheduler::Scheduler;
+
+        void Enqueue(Process& process, ReadyReason reason) override;
+        int Dequeue() override;
+        void Remove(Process& process) override;
+        std::size_t size() const override { return queue_.size(); }
+        void ForEach(const std::function<void(int)>& visit) const override;
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+        void SetPriority(Process& process, int priority) override;
+};
+
+/**
+ * One FIFO per level, so Enqueue, Dequeue and Remove are O(1). The boost back to the top level runs
+ * once per max(BOOST_INTERVAL, size) dequeues and therefore costs amortized O(1) as well.
+ */
+class MLFQScheduler : public Scheduler
+{
+    private:
+        static constexpr std::size_t BOOST_INTERVAL = 64;
+
+        std::vector<PidQueue> levels_;
+        std::size_t size_ {0};
+        std::size_t dequeuesSinceBoost_ {0};
+
+        void Boost();
+
+    public:
+        static constexpr int LEVELS = 3;
+
+        explicit MLFQScheduler(ProcessTable& processes);
+
+        void Enqueue(Process& process, ReadyReason reason) override;
+        int Dequeue() override;
+        void Remove(Process& process) override;
+        std::size_t size() const override { return size_; }
+        void ForEach(const std::function<void(int)>& visit) const override;
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+/**
+ * Virtual runtime ordered tree (std::set is a red-black tree). Enqueue, Dequeue and Remove are O(log n).
+ * Without a clock every expired time slice counts as one quantum of CPU time.
+ */
+class FairShareScheduler : public Scheduler
+{
+    private:
+        static constexpr unsigned long long QUANTUM = 1024;
+
+        std::set<std::tuple<unsigned long long, unsigned long long, int>> queue_;
+        unsigned long long arrivals_ {0};
+        unsigned long long minVruntime_ {0};
+
+        static unsigned long long Weight(int priority);
+
+    public:
+        using Scheduler::Scheduler;
+
+        void Enqueue(Process& process, ReadyReason reason) override;
+        int Dequeue() override;
+        void Remove(Process& process) override;
+        std::size_t size() const override { return queue_.size(); }
+        void ForEach(const std::function<void(int)>& visit) const override;
+        void Save(CheckpointWriter& out) const override;
+        void Load(CheckpointReader& in) override;
+};
+
+#endif
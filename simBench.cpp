@@ -0,0 +1,367 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "eventSimulator.h"
+#include "simOS.h"
+
+namespace
+{
+    constexpr int POLICIES = 4;   // SchedulingPolicy values
+    constexpr int DISK_POLICIES = 5;
+    constexpr int REPLACEMENT_ALGORITHMS = 5;
+
+    /**
+     * Fixed seed addresses over workingSetPages pages, so every run replays the same accesses.
+    */
+    std::vector<unsigned long long> Addresses(unsigned long long workingSetPages, unsigned int pageSize, std::size_t count)
+    {
+        std::mt19937_64 random(42);
+        std::uniform_int_distribution<unsigned long long> page(0, workingSetPages - 1);
+        std::vector<unsigned long long> addresses(count);
+        for (auto& address : addresses)
+            address = page(random) * pageSize;
+        return addresses;
+    }
+}
+
+/**
+ * Random accesses of one process. Args: frames of RAM, page size, working set as a percentage of RAM.
+ * Below 100% every access hits once the set is resident, above it the miss rate is 1 - 100/percentage.
+ */
+static void BM_AccessMemoryAddress(benchmark::State& state)
+{
+    const unsigned long long frames = state.range(0);
+    const unsigned int pageSize = state.range(1);
+    const unsigned long long workingSet = std::max<unsigned long long>(1, frames * state.range(2) / 100);
+    const auto addresses = Addresses(workingSet, pageSize, 1 << 16);
+
+    SimOS sim(1, frames * pageSize, pageSize);
+    sim.NewProcess();
+    for (unsigned long long address : addresses)
+        sim.AccessMemoryAddress(address);
+
+    std::size_t next = 0;
+    for (auto _ : state)
+    {
+        sim.AccessMemoryAddress(addresses[next]);
+        next = (next + 1) & (addresses.size() - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AccessMemoryAddress)
+    ->ArgNames({"frames", "pageSize", "workingSet%"})
+    ->ArgsProduct({{1 << 10, 1 << 16}, {1, 4096}, {50, 100, 200}});
+
+/**
+ * Random accesses over twice as many pages as there are frames, so half of them fault.
+ * Args: frames of RAM, replacement algorithm.
+ */
+static void BM_PageReplacement(benchmark::State& state)
+{
+    const unsigned long long frames = state.range(0);
+    const auto addresses = Addresses(frames * 2, 1, 1 << 16);
+    SimOptions options;
+    options.replacement = static_cast<ReplacementAlgorithm>(state.range(1));
+    SimOS sim(1, frames, 1, options);
+    sim.NewProcess();
+    for (unsigned long long address : addresses)
+        sim.AccessMemoryAddress(address);
+
+    std::size_t next = 0;
+    for (auto _ : state)
+    {
+        sim.AccessMemoryAddress(addresses[next]);
+        next = (next + 1) & (addresses.size() - 1);
+    }
+    state.counters["faultRate"] = sim.GetMemoryStats().FaultRate();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PageReplacement)
+    ->ArgNames({"frames", "algorithm"})
+    ->ArgsProduct({{1 << 10, 1 << 16}, benchmark::CreateDenseRange(0, REPLACEMENT_ALGORITHMS - 1, 1)});
+
+/**
+ * Locality heavy accesses: runs of 64 accesses within one page, over a working set that fits in RAM.
+ * Args: TLB sets (0 turns the TLB off), working set pages.
+ */
+static void BM_TLB(benchmark::State& state)
+{
+    const unsigned int pageSize = 4096;
+    const auto pages = Addresses(state.range(1), pageSize, 1 << 10);
+    SimOptions options;
+    options.tlb.sets = state.range(0);
+    SimOS sim(1, 1ULL << 32, pageSize, options);
+    sim.NewProcess();
+    for (unsigned long long page : pages)
+        sim.AccessMemoryAddress(page);
+
+    std::size_t next = 0;
+    unsigned long long offset = 0;
+    for (auto _ : state)
+    {
+        sim.AccessMemoryAddress(pages[next] + offset);
+        offset = (offset + 64) & (pageSize - 1);
+        if (offset == 0)
+            next = (next + 1) & (pages.size() - 1);
+    }
+    state.counters["tlbHitRatio"] = sim.GetTLBStats().HitRatio();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TLB)->ArgNames({"sets", "pages"})->ArgsProduct({{0, 16}, {64, 1 << 16}});
+
+/**
+ * Parent forks a child, waits for it, and the child exits straight into the waiting parent.
+ * Arg: pages each child touches before it exits.
+ */
+static void BM_ForkWaitExit(benchmark::State& state)
+{
+    const int pages = state.range(0);
+    SimOS sim(1, 1 << 20, 1);
+    sim.NewProcess();
+    for (auto _ : state)
+    {
+        sim.SimFork();
+        sim.SimWait();      // child runs
+        for (int page = 0; page < pages; ++page)
+            sim.AccessMemoryAddress(page);
+        sim.SimExit();      // parent runs again
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ForkWaitExit)->ArgName("pages")->Arg(0)->Arg(16);
+
+/**
+ * Copy-on-write fork of a parent with a resident set, the child writes some of the shared pages and exits.
+ * Args: resident pages of the parent, pages the child writes.
+ */
+static void BM_ForkCopyOnWrite(benchmark::State& state)
+{
+    const int resident = state.range(0);
+    const int writes = state.range(1);
+    SimOptions options;
+    options.copyOnWrite = true;
+    SimOS sim(1, 1 << 20, 1, options);
+    sim.NewProcess();
+    for (int page = 0; page < resident; ++page)
+        sim.AccessMemoryAddress(page);
+    for (auto _ : state)
+    {
+        sim.SimFork();
+        sim.SimWait();      // child runs
+        for (int page = 0; page < writes; ++page)
+            sim.WriteMemoryAddress(page);
+        sim.SimExit();      // parent runs again
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ForkCopyOnWrite)->ArgNames({"resident", "writes"})->ArgsProduct({{64, 4096}, {0, 16}});
+
+/**
+ * Sequential scan through twice as many pages as fit in RAM with every fault paged in from the swap disk.
+ * Args: page-in cluster size, every nth access is a write (0: read only).
+ */
+static void BM_DemandPaging(benchmark::State& state)
+{
+    const unsigned int cluster = state.range(0);
+    const int writeEvery = state.range(1);
+    const unsigned long long frames = 1 << 10;
+    SimOptions options;
+    options.swapDisk = 0;
+    options.pageInCluster = cluster;
+    SimOS sim(1, frames, 1, options);
+    sim.NewProcess();
+    unsigned long long page = 0;
+    for (auto _ : state)
+    {
+        if (writeEvery != 0 && page % writeEvery == 0)
+            sim.WriteMemoryAddress(page);
+        else
+            sim.AccessMemoryAddress(page);
+        while (sim.GetCPU() == NO_PROCESS)
+            sim.DiskJobCompleted(0);
+        page = page + 1 == 2 * frames ? 0 : page + 1;
+    }
+    state.counters["pageIns"] = benchmark::Counter(sim.GetMemoryStats().pageIns, benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DemandPaging)->ArgNames({"cluster", "writeEvery"})->ArgsProduct({{1, 8}, {0, 4}});
+
+/**
+ * Sequential scan through twice as many pages as fit in RAM, faults loaded instantly.
+ * Arg: largest readahead window (0: off). Items are accesses.
+ */
+static void BM_ReadAhead(benchmark::State& state)
+{
+    const unsigned long long frames = 1 << 12;
+    SimOptions options;
+    options.readAhead = state.range(0);
+    SimOS sim(1, frames, 1, options);
+    sim.NewProcess();
+    unsigned long long page = 0;
+    for (auto _ : state)
+    {
+        sim.AccessMemoryAddress(page);
+        page = page + 1 == 2 * frames ? 0 : page + 1;
+    }
+    state.counters["faults"] = benchmark::Counter(sim.GetMemoryStats().faults, benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReadAhead)->ArgName("window")->Arg(0)->Arg(32);
+
+/**
+ * Four cores each touching random pages of their own process in RAM split over NUMA nodes, with twice as
+ * many pages as frames. Args: nodes, placement (0 first touch, 1 interleave).
+ */
+static void BM_NumaPlacement(benchmark::State& state)
+{
+    const unsigned long long frames = 1 << 12;
+    SimOptions options;
+    options.numberOfCores = 4;
+    options.numaNodes = state.range(0);
+    options.numaPlacement = static_cast<NumaPlacement>(state.range(1));
+    SimOS sim(1, frames, 1, options);
+    for (int core = 0; core < 4; ++core)
+        sim.NewProcess();
+    std::mt19937_64 random(1);
+    std::uniform_int_distribution<unsigned long long> page(0, frames / 2 - 1);
+    int core = 0;
+    for (auto _ : state)
+    {
+        sim.AccessMemoryAddress(page(random), core);
+        core = (core + 1) & 3;
+    }
+    unsigned long long remote = 0;
+    for (int node = 0; node < sim.NumberOfNodes(); ++node)
+        remote += sim.GetNumaStats(node).remoteAccesses;
+    state.counters["remote"] = benchmark::Counter(remote, benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NumaPlacement)->ArgNames({"nodes", "placement"})->ArgsProduct({{1, 4}, {0, 1}});
+
+/**
+ * Open workload on the simulated clock, every quantum expiry and disk completion fired by the timing wheel.
+ * Args: cores, quantum. Items are events fired.
+ */
+static void BM_EventClock(benchmark::State& state)
+{
+    const int cores = state.range(0);
+    SimOptions options;
+    options.numberOfCores = cores;
+    ClockConfig clock;
+    clock.quantum = state.range(1);
+    WorkloadConfig workload;
+    workload.jobs = 10000;
+    workload.meanInterarrival = 40.0 / cores;
+    std::vector<Job> jobs = GenerateWorkload(workload, 2);
+    unsigned long long events = 0;
+    for (auto _ : state)
+    {
+        EventSimulator sim(2, 1 << 20, 4096, options, clock);
+        sim.Inject(jobs);
+        events += sim.Run();
+    }
+    state.SetItemsProcessed(events);
+}
+BENCHMARK(BM_EventClock)->ArgNames({"cores", "quantum"})->ArgsProduct({{1, 4}, {0, 10}})->Unit(benchmark::kMillisecond);
+
+/**
+ * Cascading termination of a wide tree. Arg: children forked by the process before it exits.
+ */
+static void BM_ForkCascadeExit(benchmark::State& state)
+{
+    const int children = state.range(0);
+    SimOS sim(1, 1 << 20, 1);
+    for (auto _ : state)
+    {
+        sim.NewProcess();
+        for (int child = 0; child < children; ++child)
+            sim.SimFork();
+        sim.SimExit();
+    }
+    state.SetItemsProcessed(state.iterations() * (children + 1));
+}
+BENCHMARK(BM_ForkCascadeExit)->ArgName("children")->Arg(16)->Arg(1024);
+
+/**
+ * Ready queue rotation. Args: runnable processes per core, cores, scheduling policy.
+ */
+static void BM_TimerInterrupt(benchmark::State& state)
+{
+    const int processes = state.range(0);
+    const int cores = state.range(1);
+    SimOptions options;
+    options.numberOfCores = cores;
+    options.scheduling = static_cast<SchedulingPolicy>(state.range(2));
+    SimOS sim(1, 1 << 10, 1, options);
+    for (int i = 0; i < processes * cores; ++i)
+        sim.NewProcess();
+
+    int core = 0;
+    for (auto _ : state)
+    {
+        sim.TimerInterrupt(core);
+        core = core + 1 == cores ? 0 : core + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerInterrupt)
+    ->ArgNames({"processes", "cores", "policy"})
+    ->ArgsProduct({{16, 4096}, {1, 8}, benchmark::CreateDenseRange(0, POLICIES - 1, 1)});
+
+/**
+ * Saturated disk: every completion puts the served process back on the CPU and it queues a new read
+ * right away, so the queue depth stays constant. Args: queued requests, disk policy.
+ */
+static void BM_DiskQueueSaturation(benchmark::State& state)
+{
+    const int depth = state.range(0);
+    SimOptions options;
+    options.diskScheduling = static_cast<DiskPolicy>(state.range(1));
+    SimOS sim(1, 1 << 10, 1, options);
+    FileId file = sim.InternFileName("data.bin");
+    std::mt19937_64 random(42);
+
+    for (int i = 0; i <= depth; ++i)
+        sim.NewProcess();
+    for (int i = 0; i <= depth; ++i)
+        sim.DiskReadRequest(0, file, random() % (1 << 20), 8);
+
+    for (auto _ : state)
+    {
+        sim.DiskJobCompleted(0);
+        sim.DiskReadRequest(0, file, random() % (1 << 20), 8);
+    }
+    state.counters["avgSeek"] = static_cast<double>(sim.GetDiskStats(0).totalSeekDistance) / sim.GetDiskStats(0).served;
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DiskQueueSaturation)
+    ->ArgNames({"depth", "diskPolicy"})
+    ->ArgsProduct({{16, 4096}, benchmark::CreateDenseRange(0, DISK_POLICIES - 1, 1)});
+
+/**
+ * Restore of a checkpoint taken with every frame in use. Arg: frames of RAM, shared by 64 processes.
+ */
+static void BM_RestoreCheckpoint(benchmark::State& state)
+{
+    const unsigned long long frames = state.range(0);
+    SimOS sim(1, frames, 1);
+    for (int i = 0; i < 64; ++i)
+        sim.NewProcess();
+    for (unsigned long long page = 0; page < frames; ++page)
+    {
+        sim.AccessMemoryAddress(page);
+        if (page % (frames / 64) == 0)
+            sim.TimerInterrupt();
+    }
+    const std::vector<unsigned char> image = sim.Checkpoint();
+
+    SimOS copy(1, 1, 1);
+    for (auto _ : state)
+        copy.RestoreCheckpoint(image.data(), image.size());
+    state.SetBytesProcessed(state.iterations() * image.size());
+}
+BENCHMARK(BM_RestoreCheckpoint)->ArgName("frames")->Arg(1 << 12)->Arg(1 << 20);
+
+BENCHMARK_MAIN();
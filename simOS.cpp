@@ -1,88 +1,273 @@
 //Henry Tse
 
 
-#include "SimOS.h"
+#include "simOS.h"
 
-SimOS::SimOS( int numberOfDisks, unsigned long long amountOfRAM, unsigned int pageSize)
-:amountOfFrames_{amountOfRAM/pageSize},pageSize_{pageSize},currentPID_{1},currentCPU_{NO_PROCESS},diskQueues_(numberOfDisks),currentIORequests_(numberOfDisks),recencyCount_{1}
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SimOS::SimOS( int numberOfDisks, unsigned long long amountOfRAM, unsigned int pageSize, int numberOfCores, LoadBalancing balancing)
+:SimOS(numberOfDisks, amountOfRAM, pageSize, SimOptions{numberOfCores, balancing})
+{
+}
+
+SimOS::SimOS( int numberOfDisks, unsigned long long amountOfRAM, unsigned int pageSize, const SimOptions& options)
+:amountOfFrames_{amountOfRAM/pageSize},pageSize_{pageSize},replacement_{options.replacement},copyOnWrite_{options.copyOnWrite},freeSharers_{NO_FRAME},
+hugeFrames_{options.hugePageSize == 0 || pageSize == 0 ? 1 : options.hugePageSize/pageSize},hugePages_{options.hugePages},nodeFrames_{amountOfFrames_},
+placement_{options.numaPlacement},currentIORequests_(numberOfDisks),diskStats_(numberOfDisks),
+swapDisk_{options.swapDisk},pageInCluster_{options.pageInCluster},swapFile_{NO_FILE},writingBack_{false},readAhead_{0},
+currentPID_{1},cpus_(std::max(options.numberOfCores, 1), NO_PROCESS),coreStats_(cpus_.size()),balancing_{options.balancing},scheduling_{options.scheduling},
+diskScheduling_{options.diskScheduling},nextCore_{0},
+profiler_(std::max(options.numberOfCores, 1), numberOfDisks)
 {
-    memoryCounter_.resize(amountOfFrames_);
+    if (options.numberOfCores < 1)
+    {
+        throw std::invalid_argument("SimOS needs at least one CPU core\n");
+    }
+    if (options.hugePageSize != 0 && (options.hugePageSize < pageSize || options.hugePageSize % pageSize != 0))
+    {
+        throw std::invalid_argument("Huge page size must be a multiple of the page size\n");
+    }
+    if (hugeFrames_ == 1)
+    {
+        hugePages_ = HugePageMode::Never;
+    }
+    if (options.tlb.sets != 0 && ((options.tlb.sets & (options.tlb.sets - 1)) != 0 || options.tlb.ways == 0))
+    {
+        throw std::invalid_argument("TLB sets must be a power of two and ways at least 1\n");
+    }
+    if (options.swapDisk < -1 || options.swapDisk >= numberOfDisks || options.pageInCluster == 0)
+    {
+        throw std::invalid_argument("Swap disk must be one of the disks and page-ins read at least one page\n");
+    }
+    if (options.numaNodes == 0 || (options.numaNodes > 1 && amountOfFrames_ / hugeFrames_ < options.numaNodes))
+    {
+        throw std::invalid_argument("Every NUMA node needs at least one page frame, or huge page block with huge pages\n");
+    }
+    if (swapDisk_ >= 0)
+    {
+        swapFile_ = fileNames_.Intern("swap");
+    }
+    for (int core = 0; core < options.numberOfCores; ++core)
+    {
+        readyQueues_.push_back(Scheduler::Create(options.scheduling, *processes_));
+    }
+    for (int disk = 0; disk < numberOfDisks; ++disk)
+    {
+        diskQueues_.push_back(IoScheduler::Create(options.diskScheduling, *processes_));
+    }
+    if (options.numaNodes > 1)
+    {
+        nodeFrames_ = amountOfFrames_ / hugeFrames_ / options.numaNodes * hugeFrames_;
+    }
+    for (unsigned int node = 0; node < options.numaNodes; ++node)
+    {
+        unsigned long long first = node * nodeFrames_;
+        unsigned long long end = node + 1 == options.numaNodes ? amountOfFrames_ : first + nodeFrames_;
+        nodes_.push_back(NumaNode{first, end, first, {}, {},
+            ReplacementPolicy::Create(options.replacement, end - first, options.workingSetWindow), NumaStats{end - first}});
+    }
+    // At most half a node, so a readahead can't evict the page it was started for. With huge pages for every
+    // fault there are no base page streams to follow.
+    if (hugePages_ != HugePageMode::Always)
+    {
+        readAhead_ = std::min<unsigned long long>(options.readAhead, nodeFrames_ / 2);
+    }
+    if (readAhead_ != 0)
+    {
+        prefetched_.assign(amountOfFrames_, 0);
+    }
+    for (int core = 0; core < cpus_.size(); ++core)
+    {
+        coreNodes_.push_back(static_cast<int>(static_cast<long long>(core) * options.numaNodes / cpus_.size()));
+    }
+    residentNext_.assign(amountOfFrames_, NO_FRAME);
+    residentPrev_.assign(amountOfFrames_, NO_FRAME);
     physicalMemory_.resize(amountOfFrames_);
+    frameUse_.assign(amountOfFrames_, FrameUse::Free);
+    dirty_.assign(amountOfFrames_, 0);
+    usedFrames_.assign((amountOfFrames_ + 63) / 64, 0);
+    if (copyOnWrite_)
+    {
+        sharerHead_.assign(amountOfFrames_, NO_FRAME);
+    }
+    if (options.tlb.sets != 0)
+    {
+        tlbs_.assign(cpus_.size(), TLB(options.tlb, hugePages_ == HugePageMode::Never ? 1 : hugeFrames_));
+    }
+    if (hugePages_ != HugePageMode::Never)
+    {
+        blockFree_.assign(amountOfFrames_ / hugeFrames_, hugeFrames_);
+    }
     for (unsigned long long i = 0; i < amountOfFrames_; ++i)
     {
         physicalMemory_[i].frameNumber = i;
+        physicalMemory_[i].references = 0;
     }
 }
 
 void SimOS::NewProcess()
 {
+    auto timer = profiler_.Time(ApiCall::NewProcess);
     int pid =  currentPID_++;
-    Process newProcess;
-    newProcess.PID = pid;
-    newProcess.logicalMemory.resize(amountOfFrames_);
-    processes_[pid] = newProcess;
-    UpdateCPU(pid);
+    Process& process = processes_->Create(pid);
+    process.core = PlaceNewProcess();
+    process.homeNode = coreNodes_[process.core];
+    ScheduleProcess(pid, ReadyReason::New);
+}
+
+int SimOS::GetCPU( int core )
+{
+    if(core < 0 || core >= cpus_.size())
+    {
+        throw std::out_of_range("Attempt to access out of bound core index\n");
+    }
+    return cpus_[core];
+}
+
+int SimOS::RunningOn( int core ) const
+{
+    if(core < 0 || core >= cpus_.size())
+    {
+        throw std::out_of_range("Attempt to access out of bound core index\n");
+    }
+    if (cpus_[core] == NO_PROCESS) {
+        throw std::logic_error("Instruction require running process, but CPU is idle.\n");
+    }
+    return cpus_[core];
 }
 
-int SimOS::GetCPU()
+int SimOS::PlaceNewProcess()
 {
-    return currentCPU_;
+    if (cpus_.size() == 1)
+    {
+        return 0;
+    }
+    if (balancing_ == LoadBalancing::Pinned)
+    {
+        int core = nextCore_;
+        nextCore_ = (nextCore_ + 1) % cpus_.size();
+        return core;
+    }
+    int best = 0;
+    for (int core = 0; core < cpus_.size(); ++core)
+    {
+        if (cpus_[core] == NO_PROCESS)
+            return core;
+        if (readyQueues_[core]->size() < readyQueues_[best]->size())
+            best = core;
+    }
+    return best;
 }
 
-void SimOS::UpdateCPU()
+void SimOS::UpdateCPU( int core )
 {
-    if (!readyQueue_.empty())
+    int next = readyQueues_[core]->Dequeue();
+    if (next == NO_PROCESS && balancing_ == LoadBalancing::WorkStealing)
     {
-        for(auto it = readyQueue_.begin(); it != readyQueue_.end();)
+        int busiest = 0;
+        for (int other = 1; other < readyQueues_.size(); ++other)
         {
-            if (processes_[*it].PID == 0 || processes_[*it].isZombie)
-            {
-                it = readyQueue_.erase(it);
-            }
-            else
-            {
-                ++it;
-            }
+            if (readyQueues_[other]->size() > readyQueues_[busiest]->size())
+                busiest = other;
         }
-        currentCPU_ = readyQueue_.front();
-        readyQueue_.pop_front();
+        next = readyQueues_[busiest]->Dequeue();
     }
-    else
+    cpus_[core] = next;
+    if (next != NO_PROCESS)
     {
-        currentCPU_ = NO_PROCESS;
+        if (!tlbs_.empty())
+            tlbs_[core].SwitchTo(next);
+        ++coreStats_[core].contextSwitches;
+        profiler_.Dispatch(core, readyQueues_[core]->size());
+        Process& process = *processes_->Find(next);
+        process.core = core;
+        process.isReady = false;
+        if (listener_ != nullptr)
+            listener_->Dispatched(core, next);
     }
 }
 
-void SimOS::UpdateCPU(int pid)
+void SimOS::ScheduleProcess(int pid, ReadyReason reason)
 {
-    if (currentCPU_ == NO_PROCESS)
+    Process& process = *processes_->Find(pid);
+    int core = process.core;
+    if (cpus_[core] != NO_PROCESS && balancing_ == LoadBalancing::WorkStealing)
+    {
+        for (int other = 0; other < cpus_.size(); ++other)
+        {
+            if (cpus_[other] == NO_PROCESS)
+            {
+                core = other;
+                break;
+            }
+        }
+    }
+
+    if (cpus_[core] == NO_PROCESS)
     {
-        currentCPU_ = pid;
+        cpus_[core] = pid;
+        process.core = core;
+        if (!tlbs_.empty())
+            tlbs_[core].SwitchTo(pid);
+        ++coreStats_[core].contextSwitches;
+        profiler_.Dispatch(core, readyQueues_[core]->size());
+        if (listener_ != nullptr)
+            listener_->Dispatched(core, pid);
     }
     else{
-        readyQueue_.push_back(pid);
-        if (readyQueue_.size() == 0)
-            readyQueue_.push_back(pid);
+        process.isReady = true;
+        readyQueues_[core]->Enqueue(process, reason);
+        coreStats_[core].maxReadyQueue = std::max<unsigned long long>(coreStats_[core].maxReadyQueue, readyQueues_[core]->size());
     }
 }
 
-void SimOS::DiskReadRequest( int diskNumber, std::string fileName)
+void SimOS::DiskReadRequest( int diskNumber, std::string fileName, int core )
+{
+    DiskReadRequest(diskNumber, fileNames_.Intern(std::move(fileName)), 0, 0, core);
+}
+
+void SimOS::DiskReadRequest( int diskNumber, std::string fileName, unsigned long long block, unsigned long long size, int core )
+{
+    DiskReadRequest(diskNumber, fileNames_.Intern(std::move(fileName)), block, size, core);
+}
+
+void SimOS::DiskReadRequest( int diskNumber, FileId file, unsigned long long block, unsigned long long size, int core )
 {
+    auto timer = profiler_.Time(ApiCall::DiskReadRequest);
     if(diskNumber >= diskQueues_.size())
     {
         throw std::out_of_range("Attempt to access out of bound disk index\n");
     }
-    FileReadRequest newRequest {currentCPU_,fileName};
+    int pid = RunningOn(core);
+    QueueRead(diskNumber, *processes_->Find(pid), file, block, size);
+    UpdateCPU(core);
+}
 
-    if(currentIORequests_[diskNumber].PID == 0)
+void SimOS::QueueRead(int diskNumber, Process& process, FileId file, unsigned long long block, unsigned long long size)
+{
+    if(currentIORequests_[diskNumber].PID == 0 && !(diskNumber == swapDisk_ && writingBack_))
     {
-        currentIORequests_[diskNumber] = newRequest;
+        StartRequest(diskNumber, DiskRequest{process.PID, file, block, size}, diskStats_[diskNumber].served);
     }
     else
     {
-        diskQueues_[diskNumber].push_back(newRequest);
+        process.ioFile = file;
+        process.ioBlock = block;
+        process.ioSize = size;
+        process.ioQueuedAt = diskStats_[diskNumber].served;
+        process.ioDisk = diskNumber;
+        diskQueues_[diskNumber]->Enqueue(process);
+        diskStats_[diskNumber].maxQueueDepth = std::max<unsigned long long>(diskStats_[diskNumber].maxQueueDepth, diskQueues_[diskNumber]->size());
     }
-    UpdateCPU();
+    profiler_.DiskQueueDepth(diskNumber, diskQueues_[diskNumber]->size());
 }
 
 FileReadRequest SimOS::GetDisk( int diskNumber )
@@ -91,7 +276,8 @@ FileReadRequest SimOS::GetDisk( int diskNumber )
     {
         throw std::out_of_range("Attempt to access out of bound disk index\n");
     }
-    return currentIORequests_[diskNumber];
+    const DiskRequest& request = currentIORequests_[diskNumber];
+    return FileReadRequest{request.PID, fileNames_.Name(request.file), request.block, request.size};
 }
 
 std::deque<FileReadRequest> SimOS::GetDiskQueue( int diskNumber )
@@ -100,95 +286,142 @@ std::deque<FileReadRequest> SimOS::GetDiskQueue( int diskNumber )
     {
         throw std::out_of_range("Attempt to access out of bound disk index\n");
     }
-    return diskQueues_[diskNumber];
+    std::deque<FileReadRequest> output;
+    ForEachDiskRequest(diskNumber, [this, &output](const Process& process) {
+        output.push_back(FileReadRequest{process.PID, fileNames_.Name(process.ioFile), process.ioBlock, process.ioSize});
+    });
+    return output;
+}
+
+DiskStats SimOS::GetDiskStats( int diskNumber ) const
+{
+    if(diskNumber < 0 || diskNumber >= diskStats_.size())
+    {
+        throw std::out_of_range("Attempt to access out of bound disk index\n");
+    }
+    return diskStats_[diskNumber];
+}
+
+std::size_t SimOS::DiskQueueSize( int diskNumber ) const
+{
+    if(diskNumber < 0 || diskNumber >= diskQueues_.size())
+    {
+        throw std::out_of_range("Attempt to access out of bound disk index\n");
+    }
+    return diskQueues_[diskNumber]->size();
 }
 
 void SimOS::DiskJobCompleted( int diskNumber )
 {
+    auto timer = profiler_.Time(ApiCall::DiskJobCompleted);
     if(diskNumber >= diskQueues_.size())
     {
         throw std::out_of_range("Attempt to access out of bound disk index\n");
     }
-    UpdateCPU(currentIORequests_[diskNumber].PID);
-    if (diskQueues_[diskNumber].empty())
-        currentIORequests_[diskNumber] = FileReadRequest();
-    else
+    if (currentIORequests_[diskNumber].PID != NO_PROCESS)
     {
-        currentIORequests_[diskNumber] = diskQueues_[diskNumber].front();
-        diskQueues_[diskNumber].pop_front();
+        Process& process = *processes_->Find(currentIORequests_[diskNumber].PID);
+        if (process.pageIn != PageIn::None)
+            FinishPageIn(process, currentIORequests_[diskNumber]);
+        ScheduleProcess(process.PID, ReadyReason::Woken);
     }
+    ServeNextRequest(diskNumber);
+    profiler_.DiskQueueDepth(diskNumber, diskQueues_[diskNumber]->size());
 }
 
-std::deque<int> SimOS::GetReadyQueue()
+std::deque<int> SimOS::GetReadyQueue( int core )
 {
-    return readyQueue_;
+    std::deque<int> output;
+    ForEachReady([&output](int pid) {
+        output.push_back(pid);
+    }, core);
+    return output;
 }
 
-void SimOS::SimFork()
+void SimOS::SimFork( int core )
 {
-    if (currentCPU_ == NO_PROCESS) {
-        throw std::logic_error("Instruction require running process, but CPU is idle.\n");
-    }
+    auto timer = profiler_.Time(ApiCall::SimFork);
+    int parentPID = RunningOn(core);
 
     int pid = currentPID_++;
-    Process newFork{pid,currentCPU_,false,false};
-    newFork.logicalMemory.resize(amountOfFrames_);
-    processes_[pid] = newFork;
-    processes_[currentCPU_].children.push_back(newFork.PID);
-    UpdateCPU(pid);
+    Process& child = processes_->Create(pid);
+    Process& parent = *processes_->Find(parentPID);
+    child.parentPID = parentPID;
+    child.core = core;
+    child.priority = parent.priority;
+    child.homeNode = parent.homeNode;
+    child.vruntime = parent.vruntime;
+    child.hugeRanges = parent.hugeRanges;
+    if (copyOnWrite_)
+    {
+        ShareMemory(parent, child);
+    }
+    parent.children.push_back(pid);
+    ScheduleProcess(pid, ReadyReason::New);
 }
 
-void SimOS::TimerInterrupt()
+void SimOS::TimerInterrupt( int core )
 {
-    if (currentCPU_ == NO_PROCESS) {
-        throw std::logic_error("Instruction require running process, but CPU is idle.\n");
-    }
-    readyQueue_.push_back(currentCPU_);
-    UpdateCPU();
+    auto timer = profiler_.Time(ApiCall::TimerInterrupt);
+    Process& process = *processes_->Find(RunningOn(core));
+    process.isReady = true;
+    readyQueues_[core]->Enqueue(process, ReadyReason::Preempted);
+    coreStats_[core].maxReadyQueue = std::max<unsigned long long>(coreStats_[core].maxReadyQueue, readyQueues_[core]->size());
+    UpdateCPU(core);
 }
 
-void SimOS::SimExit()
+void SimOS::SimExit( int core )
 {
-    if (currentCPU_ == NO_PROCESS) {
-        throw std::logic_error("Instruction require running process, but CPU is idle.\n");
-    }
-    auto& process = processes_[currentCPU_];
-    
-    if (process.parentPID == 0)
+    auto timer = profiler_.Time(ApiCall::SimExit);
+    int pid = RunningOn(core);
+    auto& process = *processes_->Find(pid);
+    Process* parent = processes_->Find(process.parentPID);
+
+    if (parent == nullptr)
     {
-        TerminateProcess(currentCPU_);
+        TerminateProcess(pid);
     }
-    else if(!processes_[process.parentPID].isWaiting)
+    else if(!parent->isWaiting)
     {
         process.isZombie = true;
-        process.logicalMemory.clear();
-        for(auto child : process.children)
+        ReleaseMemory(process);
+        for(int child : process.children)
         {
-            TerminateProcess(currentCPU_);
+            CollectSubtree(child);
         }
+        process.children.clear();
+        TerminateCollected();
     }
     else
     {
-        UpdateCPU(process.parentPID);
-        TerminateProcess(currentCPU_);
+        parent->isWaiting = false;
+        auto& siblings = parent->children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), pid));
+        ScheduleProcess(process.parentPID, ReadyReason::Woken);
+        TerminateProcess(pid);
+    }
+    UpdateCPU(core);
+
+    // Descendants running on other cores were taken off them
+    for (int other = 0; other < cpus_.size(); ++other)
+    {
+        if (cpus_[other] == NO_PROCESS)
+            UpdateCPU(other);
     }
-    UpdateCPU();
     UpdateDisk();
 }
 
-void SimOS::SimWait()
+void SimOS::SimWait( int core )
 {
-    if (currentCPU_ == NO_PROCESS) {
-        throw std::logic_error("Instruction require running process, but CPU is idle.\n");
-    }
-    auto& process = processes_[currentCPU_];
+    auto timer = profiler_.Time(ApiCall::SimWait);
+    auto& process = *processes_->Find(RunningOn(core));
     if (process.children.empty())
     {
         return;
     }
     for(auto it = process.children.begin(); it != process.children.end(); ++it)
     {
-        if(processes_[*it].isZombie)
+        if(processes_->Find(*it)->isZombie)
         {
             TerminateProcess(*it);
             process.children.erase(it);
@@ -196,96 +429,1517 @@ void SimOS::SimWait()
         }
     }
     process.isWaiting = true;
-    UpdateCPU();
+    UpdateCPU(core);
 }
 
 void SimOS::TerminateProcess(int pid)
 {
-    auto& process = processes_[pid];
-    if (!processes_[pid].children.empty())
+    CollectSubtree(pid);
+    TerminateCollected();
+}
+
+void SimOS::CollectSubtree(int pid)
+{
+    subtreeStack_.push_back(pid);
+    while (!subtreeStack_.empty())
     {
-        auto childrenCopy = process.children;
-        for(int child : childrenCopy)
+        Process* process = processes_->Find(subtreeStack_.back());
+        subtreeStack_.pop_back();
+        if (process == nullptr)
         {
-            TerminateProcess(child);
+            continue;
         }
+        doomed_.push_back(process->PID);
+        subtreeStack_.insert(subtreeStack_.end(), process->children.begin(), process->children.end());
+        process->children.clear();
     }
-    
-    if (!process.logicalMemory.empty())
+}
+
+void SimOS::TerminateCollected()
+{
+    for (int pid : doomed_)
     {
-        for (auto& logItem : process.logicalMemory) {
-            
-            {
-                physicalMemory_[logItem.frameNumber] = MemoryItem();
-                memoryCounter_[logItem.frameNumber] = 1;
-            }
+        Process& process = *processes_->Find(pid);
+        Dequeue(process);
+        if (cpus_[process.core] == pid)
+        {
+            cpus_[process.core] = NO_PROCESS;
         }
+        ReleaseMemory(process);
+        processes_->Release(pid);
+        profiler_.ProcessReleased(pid);
     }
-    process = Process();
+    doomed_.clear();
 }
 
-void SimOS::AccessMemoryAddress(unsigned long long address)
+void SimOS::ShareMemory(const Process& parent, Process& child)
 {
-    if (currentCPU_ == NO_PROCESS) {
-        throw std::logic_error("Instruction require running process, but CPU is idle.\n");
-    }
+    child.pageTable = parent.pageTable;
+    child.hugePageTable = parent.hugePageTable;
+    auto share = [this, &child](unsigned long long page, unsigned long long frame) {
+        unsigned long long node = freeSharers_;
+        if (node != NO_FRAME)
+        {
+            freeSharers_ = sharers_[node].next;
+        }
+        else
+        {
+            node = sharers_.size();
+            sharers_.emplace_back();
+        }
+        sharers_[node] = Sharer{child.PID, sharerHead_[frame]};
+        sharerHead_[frame] = node;
+        SetOwner(frame, physicalMemory_[frame].PID, physicalMemory_[frame].references + 1);
+        ++child.sharedCount;
+    };
+    child.pageTable.ForEach(share);
+    child.hugePageTable.ForEach(share);
+}
+
+void SimOS::AccessMemoryAddress(unsigned long long address, int core)
+{
+    auto timer = profiler_.Time(ApiCall::AccessMemoryAddress);
+    AccessPage(address, false, core);
+}
+
+void SimOS::WriteMemoryAddress(unsigned long long address, int core)
+{
+    auto timer = profiler_.Time(ApiCall::WriteMemoryAddress);
+    AccessPage(address, true, core);
+}
+
+void SimOS::AccessPage(unsigned long long address, bool write, int core)
+{
+    int pid = RunningOn(core);
     unsigned long long processPage = address/pageSize_;
-    auto& selectProcess = processes_[currentCPU_].logicalMemory[processPage];
 
-    if(selectProcess.PID != 0 && physicalMemory_[selectProcess.frameNumber].PID == selectProcess.PID)
+    ++memoryStats_.accesses;
+    if (!tlbs_.empty())
     {
-        memoryCounter_[selectProcess.frameNumber] = recencyCount_++;
+        // A TLB hit skips the process and page table lookups
+        unsigned long long cached = tlbs_[core].Lookup(pid, processPage);
+        if (cached != NO_FRAME && !(write && physicalMemory_[cached].references > 1))
+        {
+            if (write)
+                dirty_[cached] = 1;
+            TouchFrame(cached, core);
+            profiler_.PageHit(pid);
+            return;
+        }
     }
 
-    else{
-        unsigned long long processFrame=0;
-        auto leastRecent = std::min_element(memoryCounter_.begin(),memoryCounter_.end());
-        if (leastRecent != memoryCounter_.end())
-            processFrame = std::distance(memoryCounter_.begin(),leastRecent);
-        MemoryItem newItem{processPage,processFrame,currentCPU_};
+    Process& process = *processes_->Find(pid);
+    auto& pageTable = process.pageTable;
+    FrameUse copied = FrameUse::Free;   // kind of the shared page a write unmapped to copy it
+    if (!process.hugePageTable.empty())
+    {
+        unsigned long long head = process.hugePageTable.Find(processPage / hugeFrames_);
+        if (head != NO_FRAME && write && physicalMemory_[head].references > 1)
+        {
+            CopyOnWrite(process, head);
+            copied = FrameUse::HugeHead;
+        }
+        else if (head != NO_FRAME)
+        {
+            if (write)
+                dirty_[head] = 1;
+            TouchFrame(head, core);
+            profiler_.PageHit(pid);
+            if (!tlbs_.empty())
+                tlbs_[core].Fill(pid, processPage / hugeFrames_, true, head);
+            return;
+        }
+    }
+    unsigned long long residentFrame = pageTable.Find(processPage);
+    if (residentFrame != NO_FRAME && !prefetched_.empty() && prefetched_[residentFrame])
+    {
+        PrefetchHit(process, residentFrame, processPage);
+    }
+    if (residentFrame != NO_FRAME && write && physicalMemory_[residentFrame].references > 1)
+    {
+        CopyOnWrite(process, residentFrame);
+        copied = FrameUse::Base;
+        residentFrame = NO_FRAME;
+    }
+
+    if(residentFrame != NO_FRAME)
+    {
+        if (write)
+            dirty_[residentFrame] = 1;
+        TouchFrame(residentFrame, core);
+        profiler_.PageHit(pid);
+        if (!tlbs_.empty())
+            tlbs_[core].Fill(pid, processPage, false, residentFrame);
+    }
 
-        memoryCounter_[processFrame] = recencyCount_++;
-        physicalMemory_[newItem.frameNumber] = newItem;
-        selectProcess = newItem;
+    else{
+        if (copied == FrameUse::Free)
+        {
+            profiler_.PageMiss(pid);
+            ++memoryStats_.faults;
+            if (swapDisk_ >= 0)
+            {
+                StartPageIn(process, processPage, write, core);
+                return;
+            }
+        }
+        // A copy has the size of the shared page
+        if (copied == FrameUse::HugeHead
+            || (copied == FrameUse::Free && hugePages_ != HugePageMode::Never && WantsHugePage(process, processPage)))
+        {
+            unsigned long long head = LoadHugePage(process, processPage / hugeFrames_);
+            dirty_[head] = write;
+            CountAccess(head, core);
+            if (copied == FrameUse::Free)
+                ++memoryStats_.hugeFaults;
+            if (!tlbs_.empty())
+                tlbs_[core].Fill(pid, processPage / hugeFrames_, true, head);
+            return;
+        }
+        unsigned long long processFrame = LoadPage(process, processPage);
+        dirty_[processFrame] = write;
+        CountAccess(processFrame, core);
+        if (!tlbs_.empty())
+            tlbs_[core].Fill(pid, processPage, false, processFrame);
+        if (copied == FrameUse::Free && !prefetched_.empty())
+        {
+            ReadAhead(process, processPage, DetectStream(process, processPage));
+        }
     }
 }
 
-MemoryUsage SimOS::GetMemory()
+unsigned long long SimOS::LoadPage(Process& process, unsigned long long page)
 {
-    MemoryUsage output;
-    for(auto it = physicalMemory_.begin(); it != physicalMemory_.end(); ++it)
+    unsigned long long frame = AllocateFrame(PageKey{page, process.PID}, PlaceOnNode(process, page));
+    physicalMemory_[frame] = MemoryItem{page, frame, process.PID};
+    process.pageTable.Map(page, frame);
+    LinkResident(process, frame);
+    return frame;
+}
+
+unsigned long long SimOS::LoadHugePage(Process& process, unsigned long long hugePage)
+{
+    unsigned long long first = hugePage * hugeFrames_;
+    unsigned long long head = AllocateHugePage(PageKey{first, process.PID}, PlaceOnNode(process, hugePage));
+    for (unsigned long long i = 0; i < hugeFrames_; ++i)
     {
-        if(it->PID != 0 && !processes_[it->PID].isZombie)
-        {
-            output.push_back(*it);
-        }
+        physicalMemory_[head + i] = MemoryItem{first + i, head + i, process.PID};
     }
-    return output;
+    process.hugePageTable.Map(hugePage, head);
+    LinkResident(process, head);
+    return head;
 }
 
-void SimOS::UpdateDisk()
+bool SimOS::IsResident(const Process& process, unsigned long long page) const
 {
-    for(int i = 0; i < currentIORequests_.size(); i++)
+    return process.pageTable.Find(page) != NO_FRAME
+        || (!process.hugePageTable.empty() && process.hugePageTable.Find(page / hugeFrames_) != NO_FRAME);
+}
+
+void SimOS::StartPageIn(Process& process, unsigned long long page, bool write, int core)
+{
+    unsigned long long first = page;
+    unsigned long long end = page + 1;
+    if (hugePages_ != HugePageMode::Never && WantsHugePage(process, page))
     {
-        if (processes_[currentIORequests_[i].PID].PID == 0 || processes_[currentIORequests_[i].PID].isZombie)
+        first = page / hugeFrames_ * hugeFrames_;
+        end = first + hugeFrames_;
+        process.pageIn = PageIn::Huge;
+    }
+    else
+    {
+        // Adjacent missing pages come along in the same job
+        unsigned long long group = page / pageInCluster_ * pageInCluster_;
+        while (first > group && !IsResident(process, first - 1))
+            --first;
+        while (end - group < pageInCluster_ && !IsResident(process, end))
+            ++end;
+        // A sequential stream reads its window in the same job
+        unsigned long long window = prefetched_.empty() ? 0 : DetectStream(process, page);
+        if (process.streamStride == 1)
         {
-            currentIORequests_[i] = FileReadRequest();
+            while (end - page <= window && !IsResident(process, end)
+                && !(hugePages_ == HugePageMode::Advised && IsAdvised(process, end / hugeFrames_)))
+                ++end;
         }
-        for (auto it = diskQueues_[i].begin(); it != diskQueues_[i].end();)
+        else if (process.streamStride == -1)
         {
-            if (processes_[it->PID].PID == 0 || processes_[it->PID].isZombie)
-            {
-                it = diskQueues_[i].erase(it);
-            }
-            else
-            {
-                ++it;
-            }
+            while (page - first < window && first > 0 && !IsResident(process, first - 1)
+                && !(hugePages_ == HugePageMode::Advised && IsAdvised(process, (first - 1) / hugeFrames_)))
+                --first;
         }
-        if (currentIORequests_[i].fileName == "" && !diskQueues_[i].empty())
+        process.pageIn = PageIn::Base;
+    }
+    process.pageInWrite = write;
+    process.faultPage = page;
+    ++memoryStats_.pageIns;
+    memoryStats_.pagesRead += end - first;
+    QueueRead(swapDisk_, process, swapFile_, first, end - first);
+    UpdateCPU(core);
+}
+
+void SimOS::FinishPageIn(Process& process, const DiskRequest& request)
+{
+    if (process.pageIn == PageIn::Huge)
+    {
+        unsigned long long head = LoadHugePage(process, process.faultPage / hugeFrames_);
+        dirty_[head] = process.pageInWrite;
+        ++memoryStats_.hugeFaults;
+    }
+    else
+    {
+        // The faulting page goes last, so it is the most recently used one. With readahead the other pages
+        // are prefetched, the ones farthest along the stream replaced first.
+        bool down = process.streamStride < 0;
+        for (unsigned long long i = 0; i < request.size; ++i)
         {
-            currentIORequests_[i] = diskQueues_[i].front();
-            diskQueues_[i].pop_front();
+            unsigned long long page = down ? request.block + request.size - 1 - i : request.block + i;
+            if (page == process.faultPage)
+                continue;
+            unsigned long long frame = LoadPage(process, page);
+            dirty_[frame] = 0;
+            if (!prefetched_.empty())
+                aheadFrames_.push_back(frame);
         }
-    }   
-}
\ No newline at end of file
+        dirty_[LoadPage(process, process.faultPage)] = process.pageInWrite;
+        DemoteAhead();
+    }
+    process.pageIn = PageIn::None;
+}
+
+unsigned long long SimOS::DetectStream(Process& process, unsigned long long page)
+{
+    long long stride = static_cast<long long>(page - process.streamPage);
+    process.streamPage = page;
+    if (stride != 0 && stride == process.streamStride)
+    {
+        process.readAheadWindow = process.readAheadWindow == 0 ? std::min(READAHEAD_START, readAhead_)
+            : std::min(2 * process.readAheadWindow, readAhead_);
+    }
+    else
+    {
+        process.streamStride = stride;
+        process.readAheadWindow = 0;
+    }
+    return process.readAheadWindow;
+}
+
+void SimOS::ReadAhead(Process& process, unsigned long long page, unsigned long long window)
+{
+    const long long stride = process.streamStride;
+    const unsigned long long lastPage = ~0ULL / pageSize_;
+    for (unsigned long long i = 0; i < window; ++i)
+    {
+        // The stream ends at either end of the address space and where huge pages are advised
+        if (stride < 0 ? page < static_cast<unsigned long long>(-stride) : lastPage - page < static_cast<unsigned long long>(stride))
+            break;
+        page += stride;
+        if (hugePages_ == HugePageMode::Advised && IsAdvised(process, page / hugeFrames_))
+            break;
+        if (IsResident(process, page))
+            continue;
+        unsigned long long frame = LoadPage(process, page);
+        dirty_[frame] = 0;
+        aheadFrames_.push_back(frame);
+    }
+    DemoteAhead();
+}
+
+void SimOS::DemoteAhead()
+{
+    // Loaded first and demoted after, a readahead only evicts pages that were already cold
+    for (unsigned long long frame : aheadFrames_)
+    {
+        NumaNode& node = nodes_[NodeOf(frame)];
+        node.replacer->Demote(frame - node.first);
+        prefetched_[frame] = 1;
+    }
+    memoryStats_.prefetched += aheadFrames_.size();
+    aheadFrames_.clear();
+}
+
+void SimOS::PrefetchHit(Process& process, unsigned long long frame, unsigned long long page)
+{
+    prefetched_[frame] = 0;
+    ++memoryStats_.prefetchHits;
+    process.streamPage = page;
+}
+
+void SimOS::QueueWriteBack(unsigned long long block, unsigned long long size)
+{
+    ++memoryStats_.writeBacks;
+    if (currentIORequests_[swapDisk_].PID == NO_PROCESS && !writingBack_)
+    {
+        writingBack_ = true;
+        StartRequest(swapDisk_, DiskRequest{NO_PROCESS, swapFile_, block, size}, diskStats_[swapDisk_].served);
+    }
+    else
+    {
+        writeBacks_.push_back(WriteBack{block, size, diskStats_[swapDisk_].served});
+    }
+}
+
+void SimOS::CopyOnWrite(Process& process, unsigned long long frame)
+{
+    ShootDown(process.PID, frame);
+    if (frameUse_[frame] == FrameUse::HugeHead)
+        process.hugePageTable.Unmap(physicalMemory_[frame].pageNumber / hugeFrames_);
+    else
+        process.pageTable.Unmap(physicalMemory_[frame].pageNumber);
+    if (physicalMemory_[frame].PID == process.PID)
+    {
+        UnlinkResident(process, frame);
+        HandOver(frame);
+    }
+    else
+    {
+        DropSharer(process, frame);
+    }
+    ++memoryStats_.copyOnWrites;
+}
+
+void SimOS::HandOver(unsigned long long frame)
+{
+    unsigned long long node = sharerHead_[frame];
+    Process& heir = *processes_->Find(sharers_[node].PID);
+    sharerHead_[frame] = sharers_[node].next;
+    FreeSharer(node);
+    --heir.sharedCount;
+    LinkResident(heir, frame);
+    SetOwner(frame, heir.PID, physicalMemory_[frame].references - 1);
+}
+
+void SimOS::DropSharer(Process& process, unsigned long long frame)
+{
+    unsigned long long* link = &sharerHead_[frame];
+    while (sharers_[*link].PID != process.PID)
+    {
+        link = &sharers_[*link].next;
+    }
+    unsigned long long node = *link;
+    *link = sharers_[node].next;
+    FreeSharer(node);
+    --process.sharedCount;
+    SetOwner(frame, physicalMemory_[frame].PID, physicalMemory_[frame].references - 1);
+}
+
+void SimOS::FreeSharer(unsigned long long node)
+{
+    sharers_[node].next = freeSharers_;
+    freeSharers_ = node;
+}
+
+void SimOS::SetOwner(unsigned long long frame, int pid, unsigned int references)
+{
+    unsigned long long end = frameUse_[frame] == FrameUse::HugeHead ? frame + hugeFrames_ : frame + 1;
+    for (; frame < end; ++frame)
+    {
+        physicalMemory_[frame].PID = pid;
+        physicalMemory_[frame].references = references;
+    }
+}
+
+ResidentMemory SimOS::GetResidentMemory( int pid ) const
+{
+    const Process* process = processes_->Find(pid);
+    if (process == nullptr)
+    {
+        throw std::out_of_range("Attempt to access a process that doesn't exist\n");
+    }
+    ResidentMemory memory;
+    auto count = [this, &memory](unsigned long long frames, unsigned long long frame) {
+        unsigned int references = physicalMemory_[frame].references;
+        (references > 1 ? memory.sharedFrames : memory.privateFrames) += frames;
+        memory.proportionalFrames += static_cast<double>(frames) / references;
+    };
+    process->pageTable.ForEach([&count](unsigned long long, unsigned long long frame) { count(1, frame); });
+    process->hugePageTable.ForEach([this, &count](unsigned long long, unsigned long long frame) { count(hugeFrames_, frame); });
+    return memory;
+}
+
+void SimOS::AdviseHugePages(unsigned long long address, unsigned long long length, int core)
+{
+    Process& process = *processes_->Find(RunningOn(core));
+    if (hugePages_ == HugePageMode::Never)
+    {
+        return;
+    }
+    unsigned long long hugePageSize = hugeFrames_ * pageSize_;
+    unsigned long long first = address / hugePageSize + (address % hugePageSize != 0);
+    unsigned long long end = (address + length) / hugePageSize;
+    if (first < end)
+    {
+        process.hugeRanges.push_back(HugeRange{first, end});
+    }
+}
+
+unsigned long long SimOS::AllocateFrame(const PageKey& page, unsigned int target)
+{
+    for (unsigned int offset = 0; offset < nodes_.size(); ++offset)
+    {
+        NumaNode& node = nodes_[(target + offset) % nodes_.size()];
+        unsigned long long frame;
+        if (node.nextUnused < node.end)
+        {
+            frame = node.nextUnused++;
+        }
+        else if (!PopFreeFrame(node, frame))
+        {
+            continue;
+        }
+        node.replacer->Insert(frame - node.first, page);
+        MarkUsed(frame);
+        ++node.stats.usedFrames;
+        if (offset != 0)
+            ++node.stats.fallbacks;
+        frameUse_[frame] = FrameUse::Base;
+        if (frame / hugeFrames_ < blockFree_.size())
+            --blockFree_[frame / hugeFrames_];
+        return frame;
+    }
+
+    NumaNode& node = nodes_[target];
+    unsigned long long frame = node.first + node.replacer->Victim(page);
+    ++memoryStats_.evictions;
+    UnmapVictim(frame);
+    frameUse_[frame] = FrameUse::Base;
+    return frame;
+}
+
+bool SimOS::PopFreeFrame(NumaNode& node, unsigned long long& frame)
+{
+    // Frames taken by a huge page stay in the heap until they come up here
+    while (!node.freeFrames.empty())
+    {
+        std::pop_heap(node.freeFrames.begin(), node.freeFrames.end(), std::greater<unsigned long long>());
+        frame = node.freeFrames.back();
+        node.freeFrames.pop_back();
+        if (frameUse_[frame] == FrameUse::Free)
+            return true;
+    }
+    return false;
+}
+
+unsigned int SimOS::PlaceOnNode(const Process& process, unsigned long long unit) const
+{
+    if (nodes_.size() == 1)
+        return 0;
+    switch (placement_)
+    {
+        case NumaPlacement::Interleave: return static_cast<unsigned int>(unit % nodes_.size());
+        case NumaPlacement::Preferred:  return process.homeNode;
+        default:                        return coreNodes_[process.core];
+    }
+}
+
+void SimOS::TouchFrame(unsigned long long frame, int core)
+{
+    NumaNode& node = nodes_[NodeOf(frame)];
+    node.replacer->Touch(frame - node.first);
+    CountAccess(frame, core);
+}
+
+void SimOS::CountAccess(unsigned long long frame, int core)
+{
+    if (nodes_.size() == 1)
+        return;
+    unsigned int node = NodeOf(frame);
+    if (coreNodes_[core] == static_cast<int>(node))
+        ++nodes_[node].stats.localAccesses;
+    else
+        ++nodes_[node].stats.remoteAccesses;
+}
+
+void SimOS::UnmapVictim(unsigned long long frame)
+{
+    // The evicted page must disappear from its owner's page table
+    const MemoryItem& victim = physicalMemory_[frame];
+    ShootDown(frame);
+    if (dirty_[frame] && swapDisk_ >= 0)
+    {
+        QueueWriteBack(victim.pageNumber, frameUse_[frame] == FrameUse::HugeHead ? hugeFrames_ : 1);
+    }
+    Process* owner = processes_->Find(victim.PID);
+    profiler_.PageEvicted(victim.PID);
+    if (!prefetched_.empty() && prefetched_[frame])
+    {
+        // A wrong guess, the owner reads less ahead from now on
+        prefetched_[frame] = 0;
+        ++memoryStats_.prefetchWasted;
+        if (owner != nullptr)
+            owner->readAheadWindow /= 2;
+    }
+    if (owner != nullptr)
+    {
+        if (frameUse_[frame] == FrameUse::HugeHead)
+            owner->hugePageTable.Unmap(victim.pageNumber / hugeFrames_);
+        else
+            owner->pageTable.Unmap(victim.pageNumber);
+        UnlinkResident(*owner, frame);
+    }
+    if (victim.references > 1)
+    {
+        // A shared page leaves every process mapping it
+        for (unsigned long long node = sharerHead_[frame]; node != NO_FRAME;)
+        {
+            Process& sharer = *processes_->Find(sharers_[node].PID);
+            if (frameUse_[frame] == FrameUse::HugeHead)
+                sharer.hugePageTable.Unmap(victim.pageNumber / hugeFrames_);
+            else
+                sharer.pageTable.Unmap(victim.pageNumber);
+            --sharer.sharedCount;
+            unsigned long long next = sharers_[node].next;
+            FreeSharer(node);
+            node = next;
+        }
+        sharerHead_[frame] = NO_FRAME;
+    }
+    if (frameUse_[frame] == FrameUse::HugeHead)
+    {
+        for (unsigned long long tail = frame + 1; tail < frame + hugeFrames_; ++tail)
+            FreeFrame(tail);
+    }
+}
+
+void SimOS::ReleaseFrame(unsigned long long frame)
+{
+    NumaNode& node = nodes_[NodeOf(frame)];
+    node.replacer->Remove(frame - node.first);
+    if (frameUse_[frame] == FrameUse::HugeHead)
+    {
+        for (unsigned long long tail = frame + 1; tail < frame + hugeFrames_; ++tail)
+            FreeFrame(tail);
+    }
+    FreeFrame(frame);
+}
+
+void SimOS::FreeFrame(unsigned long long frame)
+{
+    NumaNode& node = nodes_[NodeOf(frame)];
+    node.stats.usedFrames -= ClearUsed(frame);
+    physicalMemory_[frame] = MemoryItem{0, frame, NO_PROCESS, 0};
+    frameUse_[frame] = FrameUse::Free;
+    dirty_[frame] = 0;
+    if (!prefetched_.empty() && prefetched_[frame])
+    {
+        prefetched_[frame] = 0;
+        ++memoryStats_.prefetchWasted;
+    }
+    if (node.freeFrames.size() >= 2 * (node.end - node.first))
+    {
+        // Too many stale entries of frames reused by huge pages, rebuild from the frame states
+        node.freeFrames.clear();
+        for (unsigned long long free = node.first; free < node.nextUnused; ++free)
+        {
+            if (frameUse_[free] == FrameUse::Free)
+                node.freeFrames.push_back(free);
+        }
+        std::make_heap(node.freeFrames.begin(), node.freeFrames.end(), std::greater<unsigned long long>());
+    }
+    else
+    {
+        node.freeFrames.push_back(frame);
+        std::push_heap(node.freeFrames.begin(), node.freeFrames.end(), std::greater<unsigned long long>());
+    }
+
+    unsigned long long block = frame / hugeFrames_;
+    if (block < blockFree_.size() && ++blockFree_[block] == hugeFrames_)
+    {
+        unsigned long long firstBlock = node.first / hugeFrames_;
+        unsigned long long endBlock = std::min<unsigned long long>(node.end / hugeFrames_, blockFree_.size());
+        if (node.freeBlocks.size() >= 2 * (endBlock - firstBlock))
+        {
+            node.freeBlocks.clear();
+            for (unsigned long long free = firstBlock; free < endBlock; ++free)
+            {
+                if (blockFree_[free] == hugeFrames_ && free * hugeFrames_ < node.nextUnused)
+                    node.freeBlocks.push_back(free);
+            }
+            std::make_heap(node.freeBlocks.begin(), node.freeBlocks.end(), std::greater<unsigned long long>());
+        }
+        else
+        {
+            node.freeBlocks.push_back(block);
+            std::push_heap(node.freeBlocks.begin(), node.freeBlocks.end(), std::greater<unsigned long long>());
+        }
+    }
+}
+
+void SimOS::ShootDown(unsigned long long frame)
+{
+    if (tlbs_.empty())
+    {
+        return;
+    }
+    ShootDown(physicalMemory_[frame].PID, frame);
+    if (physicalMemory_[frame].references > 1)
+    {
+        for (unsigned long long node = sharerHead_[frame]; node != NO_FRAME; node = sharers_[node].next)
+            ShootDown(sharers_[node].PID, frame);
+    }
+}
+
+void SimOS::ShootDown(int pid, unsigned long long frame)
+{
+    if (tlbs_.empty())
+    {
+        return;
+    }
+    bool huge = frameUse_[frame] == FrameUse::HugeHead;
+    unsigned long long page = huge ? physicalMemory_[frame].pageNumber / hugeFrames_ : physicalMemory_[frame].pageNumber;
+    for (TLB& tlb : tlbs_)
+    {
+        tlb.Invalidate(pid, page, huge);
+    }
+}
+
+TLBStats SimOS::GetTLBStats( int core ) const
+{
+    if(core < 0 || core >= cpus_.size())
+    {
+        throw std::out_of_range("Attempt to access out of bound core index\n");
+    }
+    return tlbs_.empty() ? TLBStats() : tlbs_[core].Stats();
+}
+
+NumaStats SimOS::GetNumaStats( int node ) const
+{
+    if(node < 0 || node >= nodes_.size())
+    {
+        throw std::out_of_range("Attempt to access out of bound NUMA node index\n");
+    }
+    return nodes_[node].stats;
+}
+
+int SimOS::GetCoreNode( int core ) const
+{
+    if(core < 0 || core >= cpus_.size())
+    {
+        throw std::out_of_range("Attempt to access out of bound core index\n");
+    }
+    return coreNodes_[core];
+}
+
+int SimOS::GetFrameNode( unsigned long long frame ) const
+{
+    if(frame >= amountOfFrames_)
+    {
+        throw std::out_of_range("Attempt to access out of bound frame index\n");
+    }
+    return NodeOf(frame);
+}
+
+void SimOS::SetHomeNode( int pid, int node )
+{
+    Process* process = processes_->Find(pid);
+    if(process == nullptr || node < 0 || node >= nodes_.size())
+    {
+        throw std::out_of_range("Attempt to set the home node of a process that doesn't exist or to a bad node\n");
+    }
+    process->homeNode = node;
+}
+
+CoreStats SimOS::GetCoreStats( int core ) const
+{
+    if(core < 0 || core >= cpus_.size())
+    {
+        throw std::out_of_range("Attempt to access out of bound core index\n");
+    }
+    return coreStats_[core];
+}
+
+bool SimOS::WantsHugePage(const Process& process, unsigned long long page)
+{
+    unsigned long long hugePage = page / hugeFrames_;
+    if (blockFree_.empty())
+    {
+        return false;
+    }
+    if (hugePages_ == HugePageMode::Advised && !IsAdvised(process, hugePage))
+    {
+        return false;
+    }
+    // Base pages already resident in this huge page keep it from being loaded as a whole
+    if (!process.pageTable.empty())
+    {
+        for (unsigned long long base = hugePage * hugeFrames_; base < (hugePage + 1) * hugeFrames_; ++base)
+        {
+            if (process.pageTable.Find(base) != NO_FRAME)
+            {
+                ++memoryStats_.hugeFallbacks;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool SimOS::IsAdvised(const Process& process, unsigned long long hugePage) const
+{
+    for (const HugeRange& range : process.hugeRanges)
+    {
+        if (hugePage >= range.first && hugePage < range.end)
+            return true;
+    }
+    return false;
+}
+
+unsigned long long SimOS::AllocateHugePage(const PageKey& page, unsigned int target)
+{
+    while (true)
+    {
+        for (unsigned int offset = 0; offset < nodes_.size(); ++offset)
+        {
+            NumaNode& node = nodes_[(target + offset) % nodes_.size()];
+            unsigned long long block = NO_FRAME;
+            while (!node.freeBlocks.empty() && block == NO_FRAME)
+            {
+                std::pop_heap(node.freeBlocks.begin(), node.freeBlocks.end(), std::greater<unsigned long long>());
+                if (blockFree_[node.freeBlocks.back()] == hugeFrames_)
+                    block = node.freeBlocks.back();
+                node.freeBlocks.pop_back();
+            }
+
+            if (block == NO_FRAME)
+            {
+                block = (node.nextUnused + hugeFrames_ - 1) / hugeFrames_;
+                if (block >= blockFree_.size() || (block + 1) * hugeFrames_ > node.end)
+                    continue;
+                // Frames skipped to align the run go to the free heap
+                for (; node.nextUnused < block * hugeFrames_; ++node.nextUnused)
+                {
+                    node.freeFrames.push_back(node.nextUnused);
+                    std::push_heap(node.freeFrames.begin(), node.freeFrames.end(), std::greater<unsigned long long>());
+                }
+            }
+            if (offset != 0)
+                ++node.stats.fallbacks;
+            return TakeBlock(block, page);
+        }
+
+        for (unsigned int offset = 0; offset < nodes_.size(); ++offset)
+        {
+            NumaNode& node = nodes_[(target + offset) % nodes_.size()];
+            if (node.stats.frames - node.stats.usedFrames < hugeFrames_)
+                continue;
+            unsigned long long firstBlock = node.first / hugeFrames_;
+            unsigned long long endBlock = std::min<unsigned long long>(node.end / hugeFrames_, blockFree_.size());
+            unsigned long long best = endBlock;
+            for (unsigned long long candidate = firstBlock; candidate < endBlock; ++candidate)
+            {
+                if (frameUse_[candidate * hugeFrames_] != FrameUse::HugeHead
+                    && (best == endBlock || blockFree_[candidate] > blockFree_[best]))
+                    best = candidate;
+            }
+            if (best != endBlock)
+            {
+                CompactBlock(best);
+                if (offset != 0)
+                    ++node.stats.fallbacks;
+                return TakeBlock(best, page);
+            }
+        }
+
+        // Not enough room anywhere, evict one more page of the node
+        NumaNode& node = nodes_[target];
+        unsigned long long victim = node.replacer->Evict();
+        ++memoryStats_.evictions;
+        UnmapVictim(node.first + victim);
+        FreeFrame(node.first + victim);
+    }
+}
+
+unsigned long long SimOS::TakeBlock(unsigned long long block, const PageKey& page)
+{
+    unsigned long long first = block * hugeFrames_;
+    NumaNode& node = nodes_[NodeOf(first)];
+    if (node.nextUnused < first + hugeFrames_)
+    {
+        node.nextUnused = first + hugeFrames_;
+    }
+    for (unsigned long long frame = first; frame < first + hugeFrames_; ++frame)
+    {
+        frameUse_[frame] = frame == first ? FrameUse::HugeHead : FrameUse::HugeTail;
+        MarkUsed(frame);
+    }
+    node.stats.usedFrames += hugeFrames_;
+    blockFree_[block] = 0;
+    node.replacer->Insert(first - node.first, page);
+    return first;
+}
+
+void SimOS::CompactBlock(unsigned long long block)
+{
+    unsigned long long first = block * hugeFrames_;
+    NumaNode& node = nodes_[NodeOf(first)];
+    if (node.nextUnused < first + hugeFrames_)
+    {
+        node.nextUnused = first + hugeFrames_;
+    }
+    // Reserved frames are skipped by the allocator while the block is emptied
+    for (unsigned long long frame = first; frame < first + hugeFrames_; ++frame)
+    {
+        if (frameUse_[frame] == FrameUse::Free)
+            frameUse_[frame] = FrameUse::Reserved;
+    }
+    for (unsigned long long from = first; from < first + hugeFrames_; ++from)
+    {
+        if (frameUse_[from] != FrameUse::Base)
+            continue;
+        unsigned long long to;
+        if (node.nextUnused < node.end)
+            to = node.nextUnused++;
+        else if (!PopFreeFrame(node, to))
+            throw std::logic_error("Compaction ran out of free frames on the node\n");
+
+        ShootDown(from);
+        MemoryItem item = physicalMemory_[from];
+        item.frameNumber = to;
+        physicalMemory_[to] = item;
+        physicalMemory_[from] = MemoryItem{0, from, NO_PROCESS, 0};
+        Process& owner = *processes_->Find(item.PID);
+        owner.pageTable.Map(item.pageNumber, to);
+        if (item.references > 1)
+        {
+            sharerHead_[to] = sharerHead_[from];
+            sharerHead_[from] = NO_FRAME;
+            for (unsigned long long node = sharerHead_[to]; node != NO_FRAME; node = sharers_[node].next)
+                processes_->Find(sharers_[node].PID)->pageTable.Map(item.pageNumber, to);
+        }
+        UnlinkResident(owner, from);
+        LinkResident(owner, to);
+        node.replacer->Move(from - node.first, to - node.first);
+        ClearUsed(from);
+        MarkUsed(to);
+        frameUse_[to] = FrameUse::Base;
+        frameUse_[from] = FrameUse::Reserved;
+        dirty_[to] = dirty_[from];
+        dirty_[from] = 0;
+        if (!prefetched_.empty())
+        {
+            prefetched_[to] = prefetched_[from];
+            prefetched_[from] = 0;
+        }
+        if (to / hugeFrames_ < blockFree_.size())
+            --blockFree_[to / hugeFrames_];
+        ++memoryStats_.migrations;
+    }
+    ++memoryStats_.compactions;
+}
+
+void SimOS::LinkResident(Process& process, unsigned long long frame)
+{
+    residentPrev_[frame] = NO_FRAME;
+    residentNext_[frame] = process.residentHead;
+    if (process.residentHead != NO_FRAME)
+        residentPrev_[process.residentHead] = frame;
+    process.residentHead = frame;
+    ++process.residentCount;
+}
+
+void SimOS::UnlinkResident(Process& process, unsigned long long frame)
+{
+    if (residentPrev_[frame] != NO_FRAME)
+        residentNext_[residentPrev_[frame]] = residentNext_[frame];
+    else
+        process.residentHead = residentNext_[frame];
+    if (residentNext_[frame] != NO_FRAME)
+        residentPrev_[residentNext_[frame]] = residentPrev_[frame];
+    residentNext_[frame] = NO_FRAME;
+    residentPrev_[frame] = NO_FRAME;
+    --process.residentCount;
+}
+
+void SimOS::ReleaseMemory(Process& process)
+{
+    if (process.sharedCount != 0)
+    {
+        // Shared pages owned by other processes are only found through the page tables
+        auto drop = [this, &process](unsigned long long, unsigned long long frame) {
+            if (physicalMemory_[frame].PID != process.PID)
+            {
+                ShootDown(process.PID, frame);
+                DropSharer(process, frame);
+            }
+        };
+        process.pageTable.ForEach(drop);
+        process.hugePageTable.ForEach(drop);
+    }
+    for (unsigned long long frame = process.residentHead; frame != NO_FRAME;)
+    {
+        unsigned long long next = residentNext_[frame];
+        residentNext_[frame] = NO_FRAME;
+        residentPrev_[frame] = NO_FRAME;
+        if (physicalMemory_[frame].references > 1)
+        {
+            ShootDown(process.PID, frame);
+            HandOver(frame);
+        }
+        else
+        {
+            ShootDown(frame);
+            ReleaseFrame(frame);
+        }
+        frame = next;
+    }
+    process.residentHead = NO_FRAME;
+    process.residentCount = 0;
+    process.pageTable.Clear();
+    process.hugePageTable.Clear();
+}
+
+bool SimOS::IsAlive(int pid) const
+{
+    const Process* process = processes_->Find(pid);
+    return process != nullptr && !process->isZombie;
+}
+
+MemoryUsage SimOS::GetMemory()
+{
+    MemoryUsage output;
+    output.reserve(usedFrameCount_);
+    ForEachUsedFrame([&output](const MemoryItem& item) {
+        output.push_back(item);
+    });
+    return output;
+}
+
+void SimOS::UpdateDisk()
+{
+    for(int i = 0; i < currentIORequests_.size(); i++)
+    {
+        if (currentIORequests_[i].PID != NO_PROCESS && !IsAlive(currentIORequests_[i].PID))
+        {
+            ServeNextRequest(i);
+        }
+    }
+}
+
+void SimOS::ServeNextRequest(int diskNumber)
+{
+    if (diskNumber == swapDisk_)
+    {
+        writingBack_ = !writeBacks_.empty();
+        if (writingBack_)
+        {
+            WriteBack next = writeBacks_.front();
+            writeBacks_.pop_front();
+            StartRequest(diskNumber, DiskRequest{NO_PROCESS, swapFile_, next.block, next.size}, next.queuedAt);
+            return;
+        }
+    }
+    DiskStats& stats = diskStats_[diskNumber];
+    int next = diskQueues_[diskNumber]->Dequeue(stats.headPosition, stats.served);
+    if (next == NO_PROCESS)
+    {
+        currentIORequests_[diskNumber] = DiskRequest();
+    }
+    else
+    {
+        Process& process = *processes_->Find(next);
+        process.ioDisk = -1;
+        StartRequest(diskNumber, DiskRequest{next, process.ioFile, process.ioBlock, process.ioSize}, process.ioQueuedAt);
+        process.ioFile = NO_FILE;
+    }
+}
+
+void SimOS::StartRequest(int diskNumber, const DiskRequest& request, unsigned long long queuedAt)
+{
+    DiskStats& stats = diskStats_[diskNumber];
+    unsigned long long wait = stats.served - queuedAt;
+    stats.totalSeekDistance += request.block > stats.headPosition ? request.block - stats.headPosition : stats.headPosition - request.block;
+    stats.totalQueueWait += wait;
+    stats.maxQueueWait = std::max(stats.maxQueueWait, wait);
+    profiler_.DiskQueueWait(diskNumber, wait);
+    stats.headPosition = request.block + request.size;
+    ++stats.served;
+    currentIORequests_[diskNumber] = request;
+    if (listener_ != nullptr)
+        listener_->DiskStarted(diskNumber, request);
+}
+
+void SimOS::Dequeue(Process& process)
+{
+    if (process.isReady)
+    {
+        readyQueues_[process.core]->Remove(process);
+        process.isReady = false;
+    }
+    else if (process.ioDisk >= 0)
+    {
+        diskQueues_[process.ioDisk]->Remove(process);
+        process.ioDisk = -1;
+    }
+}
+
+void SimOS::SetPriority( int pid, int priority )
+{
+    Process* process = processes_->Find(pid);
+    if (process == nullptr)
+    {
+        throw std::out_of_range("Attempt to access a process that doesn't exist\n");
+    }
+    readyQueues_[process->core]->SetPriority(*process, priority);
+}
+
+namespace
+{
+    struct CheckpointHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t numberOfDisks;
+        std::uint32_t numberOfCores;
+        std::uint32_t pageSize;
+        std::uint64_t amountOfFrames;
+        std::uint32_t balancing;
+        std::uint32_t scheduling;
+        std::uint32_t diskScheduling;
+        std::uint32_t replacement;
+        std::uint64_t hugeFrames;
+        std::uint32_t hugePages;
+        std::uint32_t copyOnWrite;
+        std::uint64_t checksum;         // of everything after the header
+    };
+
+    static_assert(sizeof(CheckpointHeader) == CHECKPOINT_HEADER_SIZE
+        && offsetof(CheckpointHeader, checksum) + sizeof(std::uint64_t) == CHECKPOINT_HEADER_SIZE,
+        "CheckpointHeader must not contain padding and end with the checksum");
+}
+
+std::vector<unsigned char> SimOS::Checkpoint() const
+{
+    CheckpointWriter out;
+    CheckpointHeader header{};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.numberOfDisks = diskQueues_.size();
+    header.numberOfCores = cpus_.size();
+    header.pageSize = pageSize_;
+    header.amountOfFrames = amountOfFrames_;
+    header.balancing = static_cast<std::uint32_t>(balancing_);
+    header.scheduling = static_cast<std::uint32_t>(scheduling_);
+    header.diskScheduling = static_cast<std::uint32_t>(diskScheduling_);
+    header.replacement = static_cast<std::uint32_t>(replacement_);
+    header.hugeFrames = hugeFrames_;
+    header.hugePages = static_cast<std::uint32_t>(hugePages_);
+    header.copyOnWrite = copyOnWrite_;
+    out.Write(header);
+
+    out.WriteVector(physicalMemory_);
+    out.WriteVector(residentNext_);
+    out.WriteVector(residentPrev_);
+    out.WriteVector(usedFrames_);
+    out.WriteVector(frameUse_);
+    out.WriteVector(dirty_);
+    out.WriteVector(blockFree_);
+    out.Write(nodeFrames_);
+    out.Write(placement_);
+    out.WriteVector(coreNodes_);
+    out.Write<std::uint64_t>(nodes_.size());
+    for (const NumaNode& node : nodes_)
+    {
+        out.Write(node.first);
+        out.Write(node.end);
+        out.Write(node.nextUnused);
+        out.WriteVector(node.freeFrames);
+        out.WriteVector(node.freeBlocks);
+        out.Write(node.stats);
+        node.replacer->Save(out);
+    }
+    out.WriteVector(sharerHead_);
+    out.WriteVector(sharers_);
+    out.Write(freeSharers_);
+    out.Write<std::uint64_t>(tlbs_.size());
+    for (const TLB& tlb : tlbs_)
+        tlb.Save(out);
+
+    fileNames_.Save(out);
+    out.WriteVector(currentIORequests_);
+    out.WriteVector(diskStats_);
+    out.Write(swapDisk_);
+    out.Write(pageInCluster_);
+    out.Write(readAhead_);
+    out.WriteVector(prefetched_);
+    out.Write(swapFile_);
+    out.Write(writingBack_);
+    out.WriteVector(std::vector<WriteBack>(writeBacks_.begin(), writeBacks_.end()));
+    out.Write(memoryStats_);
+
+    out.Write(currentPID_);
+    out.Write(nextCore_);
+    out.WriteVector(cpus_);
+    out.WriteVector(coreStats_);
+    processes_->Save(out);
+    for (const auto& queue : readyQueues_)
+        queue->Save(out);
+    for (const auto& queue : diskQueues_)
+        queue->Save(out);
+
+    std::vector<unsigned char> image = out.Release();
+    std::uint64_t checksum = CheckpointChecksum(image.data() + sizeof(CheckpointHeader), image.size() - sizeof(CheckpointHeader));
+    std::memcpy(image.data() + offsetof(CheckpointHeader, checksum), &checksum, sizeof(checksum));
+    return image;
+}
+
+void SimOS::SaveCheckpoint( const std::string& path ) const
+{
+    std::vector<unsigned char> image = Checkpoint();
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(reinterpret_cast<const char*>(image.data()), image.size());
+    if (!output)
+    {
+        throw std::runtime_error("Cannot write checkpoint " + path + "\n");
+    }
+}
+
+void SimOS::RestoreCheckpoint( const void* image, std::size_t length )
+{
+    // Any check may throw after part of the state is replaced, so only a fully checked image is moved in
+    SimOS restored(1, 1, 1);
+    restored.DecodeCheckpoint(image, length);
+    restored.listener_ = listener_;
+    *this = std::move(restored);
+}
+
+void SimOS::DecodeCheckpoint( const void* image, std::size_t length )
+{
+    CheckpointReader in(image, length);
+    CheckpointHeader header = in.Read<CheckpointHeader>();
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 || header.version != CHECKPOINT_VERSION)
+    {
+        throw std::runtime_error("Not a SimOS checkpoint\n");
+    }
+    if (header.checksum != CheckpointChecksum(static_cast<const unsigned char*>(image) + sizeof(header), length - sizeof(header)))
+    {
+        throw std::runtime_error("Checkpoint is corrupt\n");
+    }
+    CheckCheckpoint(header.pageSize != 0 && header.hugeFrames != 0 && header.numberOfCores != 0
+        && header.numberOfCores <= INT_MAX && header.numberOfDisks <= INT_MAX && header.copyOnWrite <= 1
+        && header.balancing <= static_cast<std::uint32_t>(LoadBalancing::Pinned)
+        && header.scheduling <= static_cast<std::uint32_t>(SchedulingPolicy::FairShare)
+        && header.diskScheduling <= static_cast<std::uint32_t>(DiskPolicy::Deadline)
+        && header.replacement <= static_cast<std::uint32_t>(ReplacementAlgorithm::WSClock)
+        && header.hugePages <= static_cast<std::uint32_t>(HugePageMode::Always));
+
+    amountOfFrames_ = header.amountOfFrames;
+    pageSize_ = header.pageSize;
+    balancing_ = static_cast<LoadBalancing>(header.balancing);
+    scheduling_ = static_cast<SchedulingPolicy>(header.scheduling);
+    diskScheduling_ = static_cast<DiskPolicy>(header.diskScheduling);
+    replacement_ = static_cast<ReplacementAlgorithm>(header.replacement);
+    hugeFrames_ = header.hugeFrames;
+    hugePages_ = static_cast<HugePageMode>(header.hugePages);
+    copyOnWrite_ = header.copyOnWrite != 0;
+
+    in.ReadVector(physicalMemory_);
+    CheckCheckpoint(physicalMemory_.size() == amountOfFrames_);
+    in.ReadVector(residentNext_);
+    in.ReadVector(residentPrev_);
+    in.ReadVector(usedFrames_);
+    usedFrameCount_ = 0;
+    for (std::uint64_t bits : usedFrames_)
+        usedFrameCount_ += __builtin_popcountll(bits);
+    in.ReadVector(frameUse_);
+    in.ReadVector(dirty_);
+    in.ReadVector(blockFree_);
+    nodeFrames_ = in.Read<unsigned long long>();
+    placement_ = in.Read<NumaPlacement>();
+    CheckCheckpoint(placement_ >= NumaPlacement::FirstTouch && placement_ <= NumaPlacement::Preferred);
+    in.ReadVector(coreNodes_);
+    std::uint64_t nodes = in.Read<std::uint64_t>();
+    nodes_.clear();
+    for (std::uint64_t index = 0; index < nodes; ++index)
+    {
+        NumaNode node;
+        node.first = in.Read<unsigned long long>();
+        node.end = in.Read<unsigned long long>();
+        node.nextUnused = in.Read<unsigned long long>();
+        in.ReadVector(node.freeFrames);
+        in.ReadVector(node.freeBlocks);
+        node.stats = in.Read<NumaStats>();
+        // Nodes tile the frames, all but the last nodeFrames_ long, and their free heaps hold their own frames
+        CheckCheckpoint(node.first == (nodes_.empty() ? 0 : nodes_.back().end) && node.end > node.first
+            && node.end <= amountOfFrames_ && (index + 1 == nodes || node.end - node.first == nodeFrames_)
+            && node.nextUnused >= node.first && node.nextUnused <= node.end
+            && std::all_of(node.freeFrames.begin(), node.freeFrames.end(),
+                [&node](unsigned long long frame) { return frame >= node.first && frame < node.nextUnused; })
+            && std::all_of(node.freeBlocks.begin(), node.freeBlocks.end(),
+                [this](unsigned long long block) { return block < blockFree_.size(); })
+            && std::is_heap(node.freeFrames.begin(), node.freeFrames.end(), std::greater<unsigned long long>())
+            && std::is_heap(node.freeBlocks.begin(), node.freeBlocks.end(), std::greater<unsigned long long>()));
+        node.replacer = ReplacementPolicy::Create(replacement_, node.end - node.first);
+        node.replacer->Load(in);
+        nodes_.push_back(std::move(node));
+    }
+    in.ReadVector(sharerHead_);
+    in.ReadVector(sharers_);
+    freeSharers_ = in.Read<unsigned long long>();
+    std::uint64_t tlbs = in.Read<std::uint64_t>();
+    tlbs_.clear();
+    for (std::uint64_t core = 0; core < tlbs && core < header.numberOfCores; ++core)
+    {
+        tlbs_.emplace_back(TLBConfig(), 1);
+        tlbs_.back().Load(in, amountOfFrames_);
+    }
+
+    fileNames_.Load(in);
+    in.ReadVector(currentIORequests_);
+    in.ReadVector(diskStats_);
+    swapDisk_ = in.Read<int>();
+    pageInCluster_ = in.Read<unsigned long long>();
+    readAhead_ = in.Read<unsigned long long>();
+    in.ReadVector(prefetched_);
+    swapFile_ = in.Read<FileId>();
+    writingBack_ = in.ReadBool();
+    std::vector<WriteBack> writeBacks;
+    in.ReadVector(writeBacks);
+    writeBacks_.assign(writeBacks.begin(), writeBacks.end());
+    memoryStats_ = in.Read<MemoryStats>();
+
+    currentPID_ = in.Read<int>();
+    nextCore_ = in.Read<int>();
+    in.ReadVector(cpus_);
+    in.ReadVector(coreStats_);
+    CheckCheckpoint(cpus_.size() == header.numberOfCores && coreStats_.size() == header.numberOfCores
+        && currentIORequests_.size() == header.numberOfDisks && diskStats_.size() == header.numberOfDisks
+        && (tlbs == 0 || tlbs == cpus_.size())
+        && residentNext_.size() == amountOfFrames_ && residentPrev_.size() == amountOfFrames_
+        && frameUse_.size() == amountOfFrames_ && dirty_.size() == amountOfFrames_
+        && prefetched_.size() == (readAhead_ != 0 ? amountOfFrames_ : 0)
+        && blockFree_.size() == (hugePages_ != HugePageMode::Never ? amountOfFrames_ / hugeFrames_ : 0)
+        && std::all_of(blockFree_.begin(), blockFree_.end(), [this](unsigned long long free) { return free <= hugeFrames_; })
+        && usedFrames_.size() == (amountOfFrames_ + 63) / 64
+        && (amountOfFrames_ % 64 == 0 || usedFrames_.back() >> (amountOfFrames_ % 64) == 0)
+        && swapDisk_ >= -1 && swapDisk_ < static_cast<int>(header.numberOfDisks) && pageInCluster_ != 0 && pageInCluster_ <= UINT_MAX
+        && readAhead_ <= (hugePages_ != HugePageMode::Always ? nodeFrames_ / 2 : 0)
+        && swapFile_ < fileNames_.size() && (swapDisk_ >= 0 || (!writingBack_ && writeBacks_.empty()))
+        && sharerHead_.size() == (copyOnWrite_ ? amountOfFrames_ : 0) && nodes_.size() == nodes && !nodes_.empty()
+        && nodes_.back().end == amountOfFrames_ && (nodes_.size() == 1 || nodeFrames_ % hugeFrames_ == 0)
+        && coreNodes_.size() == cpus_.size()
+        && std::all_of(coreNodes_.begin(), coreNodes_.end(), [this](int node) { return node >= 0 && node < nodes_.size(); })
+        && currentPID_ > 0 && nextCore_ >= 0 && nextCore_ < static_cast<int>(cpus_.size()));
+    processes_->Load(in);
+    readyQueues_.clear();
+    for (unsigned int core = 0; core < header.numberOfCores; ++core)
+    {
+        readyQueues_.push_back(Scheduler::Create(scheduling_, *processes_));
+        readyQueues_.back()->Load(in);
+    }
+    diskQueues_.clear();
+    for (unsigned int disk = 0; disk < header.numberOfDisks; ++disk)
+    {
+        diskQueues_.push_back(IoScheduler::Create(diskScheduling_, *processes_));
+        diskQueues_.back()->Load(in);
+    }
+    CheckCheckpoint(in.AtEnd() && currentPID_ >= processes_->NextPID());
+    CheckRestored();
+    doomed_.clear();
+    subtreeStack_.clear();
+    profiler_ = SimProfiler(header.numberOfCores, header.numberOfDisks);
+}
+
+void SimOS::CheckRestored() const
+{
+    // Frames: owners, huge page runs, sharer chains and the replacement state of their node
+    std::vector<unsigned char> pooled(sharers_.size(), 0);
+    std::vector<unsigned long long> nodeUsed(nodes_.size(), 0);
+    std::vector<unsigned long long> blockFree(blockFree_.size(), 0);
+    unsigned long long usedCount = 0;
+    unsigned long long ownedCount = 0;
+    for (unsigned long long frame = 0; frame < amountOfFrames_; ++frame)
+    {
+        const MemoryItem& item = physicalMemory_[frame];
+        FrameUse use = frameUse_[frame];
+        bool head = use == FrameUse::Base || use == FrameUse::HugeHead;
+        const NumaNode& node = nodes_[NodeOf(frame)];
+        CheckCheckpoint(item.frameNumber == frame && use <= FrameUse::Reserved
+            && (residentNext_[frame] == NO_FRAME || residentNext_[frame] < amountOfFrames_)
+            && (residentPrev_[frame] == NO_FRAME || residentPrev_[frame] < amountOfFrames_)
+            && node.replacer->Tracks(frame - node.first) == head
+            && (use == FrameUse::Free || use == FrameUse::Reserved ? item.PID == NO_PROCESS && item.references == 0
+                : processes_->Find(item.PID) != nullptr && IsUsed(frame))
+            && (sharerHead_.empty() || head || sharerHead_[frame] == NO_FRAME));
+        if (use == FrameUse::HugeHead)
+        {
+            CheckCheckpoint(frame % hugeFrames_ == 0 && amountOfFrames_ - frame >= hugeFrames_);
+            for (unsigned long long tail = frame + 1; tail < frame + hugeFrames_; ++tail)
+                CheckCheckpoint(frameUse_[tail] == FrameUse::HugeTail && physicalMemory_[tail].PID == item.PID
+                    && physicalMemory_[tail].references == item.references);
+        }
+        else if (use == FrameUse::HugeTail)
+        {
+            CheckCheckpoint(frameUse_[frame / hugeFrames_ * hugeFrames_] == FrameUse::HugeHead);
+        }
+        if (use != FrameUse::Free && use != FrameUse::Reserved)
+        {
+            ++usedCount;
+            ++nodeUsed[NodeOf(frame)];
+        }
+        else if (use == FrameUse::Free && frame / hugeFrames_ < blockFree.size())
+        {
+            ++blockFree[frame / hugeFrames_];
+        }
+        if (!head)
+            continue;
+        ++ownedCount;
+        unsigned long long mapping = 1;
+        if (!sharerHead_.empty())
+        {
+            for (unsigned long long link = sharerHead_[frame]; link != NO_FRAME; link = sharers_[link].next)
+            {
+                CheckCheckpoint(link < sharers_.size() && !pooled[link] && sharers_[link].PID != item.PID
+                    && processes_->Find(sharers_[link].PID) != nullptr);
+                pooled[link] = 1;
+                ++mapping;
+            }
+        }
+        CheckCheckpoint(item.references == mapping);
+    }
+    for (unsigned long long link = freeSharers_; link != NO_FRAME; link = sharers_[link].next)
+    {
+        CheckCheckpoint(link < sharers_.size() && !pooled[link]);
+        pooled[link] = 1;
+    }
+    CheckCheckpoint(usedCount == usedFrameCount_ && std::all_of(pooled.begin(), pooled.end(), [](unsigned char in) { return in; }));
+    CheckCheckpoint(blockFree == blockFree_);
+
+    // Nodes: counters, and every free frame either never used yet or on the free heap
+    for (std::size_t index = 0; index < nodes_.size(); ++index)
+    {
+        const NumaNode& node = nodes_[index];
+        CheckCheckpoint(node.stats.frames == node.end - node.first && node.stats.usedFrames == nodeUsed[index]);
+        std::vector<unsigned char> heaped(node.nextUnused - node.first, 0);
+        for (unsigned long long frame : node.freeFrames)
+            heaped[frame - node.first] = 1;
+        for (unsigned long long frame = node.first; frame < node.end; ++frame)
+            CheckCheckpoint(frame < node.nextUnused ? frameUse_[frame] != FrameUse::Free || heaped[frame - node.first]
+                : frameUse_[frame] == FrameUse::Free);
+    }
+
+    // Processes: their fields, mappings, resident set lists and family
+    int cores = static_cast<int>(cpus_.size());
+    int disks = static_cast<int>(diskQueues_.size());
+    unsigned long long pageInLimit = std::max(hugeFrames_, pageInCluster_ + readAhead_);   // pages a page-in reads at most
+    unsigned long long residentCount = 0;
+    std::size_t ready = 0;
+    std::size_t waiting = 0;
+    std::size_t parented = 0;
+    std::vector<int> children;
+    processes_->ForEach([&](const Process& process) {
+        CheckCheckpoint(process.core >= 0 && process.core < cores && process.homeNode >= 0
+            && process.homeNode < static_cast<int>(nodes_.size()) && process.ioDisk >= -1 && process.ioDisk < disks
+            && process.ioFile < fileNames_.size() && !(process.isReady && process.ioDisk >= 0)
+            && process.readAheadWindow <= readAhead_ && process.schedLevel >= 0
+            && process.schedLevel < (scheduling_ == SchedulingPolicy::MLFQ ? MLFQScheduler::LEVELS : 1)
+            && (process.pageIn != PageIn::Huge || hugePages_ != HugePageMode::Never)
+            && (process.pageIn == PageIn::None || (swapDisk_ >= 0 && !process.isReady && (process.ioDisk < 0
+                ? currentIORequests_[swapDisk_].PID == process.PID : process.ioDisk == swapDisk_ && process.ioSize <= pageInLimit))));
+        unsigned long long owned = 0;
+        unsigned long long shared = 0;
+        auto mapped = [&](unsigned long long frame) {
+            const MemoryItem& item = physicalMemory_[frame];
+            if (item.PID == process.PID)
+            {
+                ++owned;
+                return;
+            }
+            unsigned long long link = sharerHead_.empty() ? NO_FRAME : sharerHead_[frame];
+            while (link != NO_FRAME && sharers_[link].PID != process.PID)
+                link = sharers_[link].next;
+            CheckCheckpoint(link != NO_FRAME);
+            ++shared;
+        };
+        process.pageTable.ForEach([&](unsigned long long page, unsigned long long frame) {
+            CheckCheckpoint(frame < amountOfFrames_ && frameUse_[frame] == FrameUse::Base && physicalMemory_[frame].pageNumber == page);
+            mapped(frame);
+        });
+        process.hugePageTable.ForEach([&](unsigned long long page, unsigned long long frame) {
+            CheckCheckpoint(frame < amountOfFrames_ && frameUse_[frame] == FrameUse::HugeHead
+                && physicalMemory_[frame].pageNumber / hugeFrames_ == page);
+            mapped(frame);
+        });
+        unsigned long long linked = 0;
+        unsigned long long previous = NO_FRAME;
+        for (unsigned long long frame = process.residentHead; frame != NO_FRAME; frame = residentNext_[frame])
+        {
+            CheckCheckpoint(frame < amountOfFrames_ && linked < process.residentCount && residentPrev_[frame] == previous
+                && physicalMemory_[frame].PID == process.PID);
+            previous = frame;
+            ++linked;
+        }
+        CheckCheckpoint(linked == process.residentCount && owned == linked && shared == process.sharedCount);
+        residentCount += linked;
+
+        for (int pid : process.children)
+        {
+            const Process* child = processes_->Find(pid);
+            CheckCheckpoint(child != nullptr && child->parentPID == process.PID);
+            children.push_back(pid);
+        }
+        if (processes_->Find(process.parentPID) != nullptr)
+            ++parented;
+        ready += process.isReady;
+        waiting += process.ioDisk >= 0;
+    });
+    std::sort(children.begin(), children.end());
+    CheckCheckpoint(residentCount == ownedCount && children.size() == parented
+        && std::adjacent_find(children.begin(), children.end()) == children.end());
+
+    // Cores, disks and the queues: every process in at most one place, where its own fields say it is
+    for (int core = 0; core < cores; ++core)
+    {
+        const Process* running = processes_->Find(cpus_[core]);
+        CheckCheckpoint(cpus_[core] == NO_PROCESS || (running != nullptr && running->core == core && !running->isReady
+            && running->ioDisk < 0 && !running->isZombie));
+        readyQueues_[core]->ForEach([this, core, &ready](int pid) {
+            const Process& process = *processes_->Find(pid);
+            CheckCheckpoint(process.isReady && process.core == core && cpus_[core] != pid);
+            --ready;
+        });
+    }
+    for (int disk = 0; disk < disks; ++disk)
+    {
+        const DiskRequest& request = currentIORequests_[disk];
+        const Process* serving = processes_->Find(request.PID);
+        CheckCheckpoint(request.file < fileNames_.size() && (request.PID == NO_PROCESS
+            || (serving != nullptr && !serving->isReady && serving->ioDisk < 0 && cpus_[serving->core] != request.PID
+                && (serving->pageIn == PageIn::None || (disk == swapDisk_ && request.size <= pageInLimit)))));
+        diskQueues_[disk]->ForEach([this, disk, &waiting](int pid) {
+            CheckCheckpoint(processes_->Find(pid)->ioDisk == disk);
+            --waiting;
+        });
+    }
+    CheckCheckpoint(ready == 0 && waiting == 0);
+}
+
+void SimOS::RestoreCheckpoint( const std::string& path )
+{
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        throw std::runtime_error("Cannot open checkpoint " + path + "\n");
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        close(file);
+        throw std::runtime_error("Cannot read checkpoint " + path + "\n");
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Cannot map checkpoint " + path + "\n");
+    }
+    try
+    {
+        RestoreCheckpoint(mapping, info.st_size);
+    }
+    catch (...)
+    {
+        munmap(mapping, info.st_size);
+        throw;
+    }
+    munmap(mapping, info.st_size);
+}
@@ -10,32 +10,198 @@
 #include<unordered_map>
 #include <iterator>
 #include <stdexcept>
+#include <memory>
+#include <queue>
+#include <functional>
+
+#include "replacementPolicy.h"
+#include "pageTable.h"
+#include "tlb.h"
+#include "processTable.h"
+#include "scheduler.h"
+#include "ioScheduler.h"
+#include "fileNameTable.h"
+#include "simProfiler.h"
 
 struct FileReadRequest
 {
     int  PID{0};
     std::string fileName{""};
+    unsigned long long block{0}; // first block read, used by the seek ordered disk policies
+    unsigned long long size{0};  // number of blocks read
+};
+
+/**
+ * Request in service on a disk, with the file name interned.
+ */
+struct DiskRequest
+{
+    int PID{0};
+    FileId file{NO_FILE};
+    unsigned long long block{0};
+    unsigned long long size{0};
+};
+
+/**
+ * Per disk counters. Distances are in blocks, waits in requests the disk served while the request was queued.
+ */
+struct DiskStats
+{
+    unsigned long long served{0};
+    unsigned long long totalSeekDistance{0};
+    unsigned long long totalQueueWait{0};
+    unsigned long long maxQueueWait{0};
+    unsigned long long headPosition{0};
+    unsigned long long maxQueueDepth{0};   // longest the queue of waiting requests got
+};
+
+/**
+ * Per core scheduling counters. A context switch is the core starting to run a process.
+ */
+struct CoreStats
+{
+    unsigned long long contextSwitches{0};
+    unsigned long long maxReadyQueue{0};
+};
+ 
+/**
+ * Memory reference counters, kept whether or not profiling is compiled in.
+ */
+struct MemoryStats
+{
+    unsigned long long accesses{0};
+    unsigned long long faults{0};
+    unsigned long long evictions{0};
+    unsigned long long hugeFaults{0};      // faults that loaded a whole huge page
+    unsigned long long hugeFallbacks{0};   // huge page faults served with a base page instead
+    unsigned long long compactions{0};     // blocks emptied by migrating their pages to make room for a huge page
+    unsigned long long migrations{0};      // pages moved by compaction
+    unsigned long long copyOnWrites{0};    // shared pages copied because a process wrote to them
+    unsigned long long pageIns{0};         // demand paging: disk jobs that read faulting pages from swap
+    unsigned long long pagesRead{0};       // pages those jobs read, clustering reads several per fault
+    unsigned long long writeBacks{0};      // dirty pages written to swap when they were evicted
+    unsigned long long prefetched{0};      // readahead: pages loaded before they were accessed
+    unsigned long long prefetchHits{0};    // prefetched pages accessed while resident, each one a fault avoided
+    unsigned long long prefetchWasted{0};  // prefetched pages evicted or released without an access
+
+    double FaultRate() const { return accesses == 0 ? 0.0 : static_cast<double>(faults) / accesses; }
+    double PrefetchAccuracy() const { return prefetched == 0 ? 0.0 : static_cast<double>(prefetchHits) / prefetched; }
 };
  
 struct MemoryItem
 {
     unsigned long long pageNumber;
     unsigned long long frameNumber;
-    int PID; // PID of the process using this frame of memory
+    int PID; // PID of the process using this frame of memory, the owner if it is shared
+    unsigned int references{1}; // processes mapping the frame, more than 1 after a copy-on-write fork
+};
+
+/**
+ * Resident memory of one process in frames. A frame is shared while another process maps it as well.
+ * proportionalFrames splits every frame evenly between the processes mapping it, like PSS.
+ */
+struct ResidentMemory
+{
+    unsigned long long privateFrames{0};
+    unsigned long long sharedFrames{0};
+    double proportionalFrames{0.0};
 };
  
 using MemoryUsage = std::vector<MemoryItem>;
+
+/**
+ * Which NUMA node a page fault takes its frame from. When that node has no free frame the next node with one
+ * is used, and only when RAM is full a page is evicted, chosen by the replacement state of that node.
+ * FirstTouch: the node of the core the faulting process runs on.
+ * Interleave: the page number (huge page number for a huge page) modulo the number of nodes.
+ * Preferred:  the home node of the process, see SimOS::SetHomeNode.
+ */
+enum class NumaPlacement
+{
+    FirstTouch,
+    Interleave,
+    Preferred
+};
+
+/**
+ * Counters of one NUMA node. An access is local when the core making it belongs to the node holding the
+ * frame. fallbacks counts pages put on this node because the node the placement chose had no free frame.
+ */
+struct NumaStats
+{
+    unsigned long long frames{0};
+    unsigned long long usedFrames{0};
+    unsigned long long localAccesses{0};
+    unsigned long long remoteAccesses{0};
+    unsigned long long fallbacks{0};
+};
  
-constexpr int NO_PROCESS{ 0 };
+/**
+ * How runnable processes are spread over the cores of a multi-core SimOS.
+ * WorkStealing: new processes go to the least loaded core, a process that becomes ready runs on any idle core,
+ *               and a core that runs out of work takes the oldest process from the longest ready queue.
+ * Pinned:       new processes are assigned cores round robin, forked children stay with their parent,
+ *               and processes never leave their core.
+ */
+enum class LoadBalancing
+{
+    WorkStealing,
+    Pinned
+};
+
+/**
+ * When a page fault loads a huge page instead of a base page, like transparent huge pages.
+ * Never:   huge pages are off.
+ * Advised: only inside the ranges a process passed to AdviseHugePages.
+ * Always:  for every fault.
+ * A huge page is a run of hugePageSize / pageSize frames, aligned to its own size. If RAM has no such run
+ * free, pages are evicted until enough frames are free and the block with the fewest used frames is
+ * compacted. A fault falls back to a base page when part of the huge page is already resident as base pages.
+ */
+enum class HugePageMode
+{
+    Never,
+    Advised,
+    Always
+};
+
+/**
+ * Optional machine and policy settings of a SimOS.
+ */
+struct SimOptions
+{
+    int numberOfCores {1};
+    LoadBalancing balancing {LoadBalancing::WorkStealing};
+    SchedulingPolicy scheduling {SchedulingPolicy::RoundRobin};
+    DiskPolicy diskScheduling {DiskPolicy::FIFO};
+    ReplacementAlgorithm replacement {ReplacementAlgorithm::LRU};
+    unsigned long long workingSetWindow {0};   // WSClock window in memory references, 0 means the number of frames
+    unsigned long long hugePageSize {0};       // bytes, a multiple of pageSize, 0 disables huge pages
+    HugePageMode hugePages {HugePageMode::Never};
+    TLBConfig tlb;                             // per core TLBs, off by default
+    bool copyOnWrite {false};                  // SimFork shares the parent's pages instead of starting the child empty
+    int swapDisk {-1};                         // demand paging from this disk, -1 loads faulting pages instantly
+    unsigned int pageInCluster {1};            // pages a page-in may read, see SimOS::AccessMemoryAddress
+    unsigned int numaNodes {1};                // frames and cores are split evenly between the nodes
+    NumaPlacement numaPlacement {NumaPlacement::FirstTouch};
+    unsigned int readAhead {0};                // largest readahead window in pages, 0 turns readahead off
+};
 
-struct Process
+/**
+ * Told when a core starts running a process and when a disk starts serving a request, e.g. to schedule
+ * their completion on a simulated clock. Called from inside SimOS calls, so it must not call SimOS back.
+ */
+class SimListener
 {
-    int PID {0};
-    int parentPID {0};
-    bool isWaiting = false;
-    bool isZombie = false;
-    std::vector<int> children;
-    MemoryUsage logicalMemory;
+    public:
+        virtual ~SimListener() = default;
+
+        virtual void Dispatched(int core, int pid) = 0;
+
+        /**
+         * request.PID is 0 for a write-back to the swap disk.
+        */
+        virtual void DiskStarted(int diskNumber, const DiskRequest& request) = 0;
 };
 
 class SimOS
@@ -45,54 +211,395 @@ class SimOS
         //Memory Items
         unsigned long long amountOfFrames_;
         unsigned int pageSize_;
-        int recencyCount_;
-        std::vector<int> memoryCounter_;
         MemoryUsage physicalMemory_;
-        
+        ReplacementAlgorithm replacement_;
+        MemoryStats memoryStats_;
+        std::vector<unsigned long long> residentNext_; // resident set lists threaded through the frames
+        std::vector<unsigned long long> residentPrev_;
+        std::vector<unsigned char> dirty_;        // written since it was loaded, by head frame for a huge page
+        std::vector<std::uint64_t> usedFrames_;   // bitmap of the frames holding a page, bit frame % 64 of word frame / 64
+        unsigned long long usedFrameCount_ {0};
+
+        // Copy-on-write. The owner of a shared frame keeps it in its resident set list, the other processes
+        // mapping it are chained from sharerHead_ through a pool of nodes, newest first.
+        struct Sharer
+        {
+            int PID;
+            unsigned long long next;
+        };
+        bool copyOnWrite_;
+        std::vector<unsigned long long> sharerHead_; // per frame, NO_FRAME while only the owner maps it
+        std::vector<Sharer> sharers_;
+        unsigned long long freeSharers_;             // free list through the pool, NO_FRAME when empty
+
+        // Huge pages. Frames are grouped in aligned blocks of hugeFrames_, the size of a huge page.
+        enum class FrameUse : unsigned char { Free, Base, HugeHead, HugeTail, Reserved };
+        unsigned long long hugeFrames_;           // 1 when huge pages are off
+        HugePageMode hugePages_;
+        std::vector<FrameUse> frameUse_;
+        std::vector<unsigned long long> blockFree_;  // free frames of every complete block
+        std::vector<TLB> tlbs_;                   // one per core, empty when the TLB is off
+
+        // NUMA nodes. A node owns the frames [first, end), whole huge page blocks except at the end of RAM,
+        // with free frames and replacement state of its own. Its policy numbers the frames from first.
+        struct NumaNode
+        {
+            unsigned long long first;
+            unsigned long long end;
+            unsigned long long nextUnused;                // frames from here to end were never used
+            std::vector<unsigned long long> freeFrames;   // min-heap of released frames
+            std::vector<unsigned long long> freeBlocks;   // min-heap of blocks that became completely free, checked lazily
+            std::unique_ptr<ReplacementPolicy> replacer;
+            NumaStats stats;
+        };
+        std::vector<NumaNode> nodes_;
+        unsigned long long nodeFrames_;           // frames of every node but the last
+        NumaPlacement placement_;
+        std::vector<int> coreNodes_;              // node of every core
 
         //Disk Items
-        std::vector<FileReadRequest> currentIORequests_;
-        std::vector<std::deque<FileReadRequest>> diskQueues_;
+        FileNameTable fileNames_;
+        std::vector<DiskRequest> currentIORequests_;
+        std::vector<std::unique_ptr<IoScheduler>> diskQueues_;
+        std::vector<DiskStats> diskStats_;
+
+        // Demand paging. Page p of a process lives in block p of the swap file on the swap disk.
+        // Write-backs belong to no process, they queue separately and go before the page-ins.
+        struct WriteBack
+        {
+            unsigned long long block;
+            unsigned long long size;
+            unsigned long long queuedAt;
+        };
+        int swapDisk_;                      // -1 without demand paging
+        unsigned long long pageInCluster_;
+        FileId swapFile_;
+        std::deque<WriteBack> writeBacks_;
+        bool writingBack_;                  // the swap disk serves a write-back
+
+        // Readahead
+        static constexpr unsigned long long READAHEAD_START = 4;   // window of a newly detected stream
+        unsigned long long readAhead_;               // largest window, 0 when readahead is off
+        std::vector<unsigned char> prefetched_;      // loaded by readahead and not accessed since, empty when off
+        std::vector<unsigned long long> aheadFrames_; // frames the running readahead loaded
 
         //Process/CPU Items
         int currentPID_;
-        std::unordered_map<int,Process> processes_;
+        std::unique_ptr<ProcessTable> processes_ {std::make_unique<ProcessTable>()}; // on the heap, so the queues' references to it survive moving the SimOS
 
-        int currentCPU_;
-        std::deque<int> readyQueue_;
+        std::vector<int> cpus_;             // PID running on each core
+        std::vector<CoreStats> coreStats_;
+        std::vector<std::unique_ptr<Scheduler>> readyQueues_; // one run queue per core
+        LoadBalancing balancing_;
+        SchedulingPolicy scheduling_;
+        DiskPolicy diskScheduling_;
+        int nextCore_;                      // next core for round robin placement
+        std::vector<int> doomed_;           // scratch lists of cascading termination, kept to reuse their capacity
+        std::vector<int> subtreeStack_;
+
+        SimProfiler profiler_;
+        SimListener* listener_ {nullptr};
         
         //Private Helper Methods
 
         /**
-         * Runs after instruction to change process in CPU.
-         * Checks the ready queue and updates the CPU depending on if there are any processes queueing.
+         * Runs after instruction to change process in the CPU core.
+         * Checks the ready queue of the core and updates the core depending on if there are any processes queueing.
+         * With work stealing an empty core takes work from the longest ready queue.
         */
-        void UpdateCPU();
+        void UpdateCPU(int core);
         
         /**
-         * Checks the ready queue and updates the CPU depending on if there are any processes queueing.
-         * Inserts new pid into CPU or ready queue.
+         * Inserts a runnable pid into the CPU of its core, an idle core (work stealing) or the ready queue of its core.
+        */
+        void ScheduleProcess(int pid, ReadyReason reason);
+
+        /**
+         * Returns the PID running on the core.
+         * Throws std::out_of_range for a bad core number and std::logic_error if the core is idle.
+        */
+        int RunningOn(int core) const;
+
+        /**
+         * Core a brand new process starts on.
         */
-        void UpdateCPU(int pid);
+        int PlaceNewProcess();
 
         /**
         * Executes cascading termination on a process.
         */
         void TerminateProcess(int pid);
 
+        /**
+        * Adds the process and all its descendants to doomed_. Walks the tree with an explicit stack,
+        * so deep fork chains can't overflow the call stack, and empties the children lists on the way.
+        */
+        void CollectSubtree(int pid);
+
+        /**
+        * Tears down every process in doomed_ in one pass: queue entries, cores and frames are released,
+        * then the table slots. The disks are updated once by the caller.
+        */
+        void TerminateCollected();
+
         /**
         * Updates the disk queues based on terminated processes
         */
         void UpdateDisk();
 
+        /**
+        * Puts a read of the process into service if the disk is idle, or queues it.
+        */
+        void QueueRead(int diskNumber, Process& process, FileId file, unsigned long long block, unsigned long long size);
+
+        /**
+        * Moves the next queued request of the disk into service, or leaves the disk idle.
+        */
+        void ServeNextRequest(int diskNumber);
+
+        /**
+        * Puts the request into service on the disk and moves the head to the end of it.
+        */
+        void StartRequest(int diskNumber, const DiskRequest& request, unsigned long long queuedAt);
+
+        /**
+        * Shared body of AccessMemoryAddress and WriteMemoryAddress.
+        */
+        void AccessPage(unsigned long long address, bool write, int core);
+
+        /**
+        * Maps every page of the parent into the child as well, the frames become shared.
+        */
+        void ShareMemory(const Process& parent, Process& child);
+
+        /**
+        * Unmaps a shared page from a process about to write to it, so it can fault in a private copy.
+        */
+        void CopyOnWrite(Process& process, unsigned long long frame);
+
+        /**
+        * The owner of a shared frame stopped mapping it and took it off its resident set list. The process
+        * that mapped it most recently becomes the owner.
+        */
+        void HandOver(unsigned long long frame);
+
+        /**
+        * A process mapping a shared frame it doesn't own stopped mapping it.
+        */
+        void DropSharer(Process& process, unsigned long long frame);
+
+        /**
+        * Returns a node to the pool.
+        */
+        void FreeSharer(unsigned long long node);
+
+        /**
+        * Writes the owner and reference count into the frame table, for every frame of a huge page.
+        */
+        void SetOwner(unsigned long long frame, int pid, unsigned int references);
+
+        /**
+        * Loads a base page or the huge page with that number into free or evicted frames and maps it.
+        * Returns the frame, the first one for a huge page.
+        */
+        unsigned long long LoadPage(Process& process, unsigned long long page);
+        unsigned long long LoadHugePage(Process& process, unsigned long long hugePage);
+
+        /**
+        * True if the page is mapped, as a base page or as part of a huge page.
+        */
+        bool IsResident(const Process& process, unsigned long long page) const;
+
+        /**
+        * Blocks the process running on the core and queues the page-in of a faulting page on the swap disk.
+        */
+        void StartPageIn(Process& process, unsigned long long page, bool write, int core);
+
+        /**
+        * Maps the pages a completed page-in read.
+        */
+        void FinishPageIn(Process& process, const DiskRequest& request);
+
+        /**
+        * Feeds a base page fault to the stream detector of the process. Returns how many pages to read ahead,
+        * 0 unless the distance to the previous fault repeats. The window of a stream starts at READAHEAD_START
+        * and doubles with every fault that continues it, up to readAhead_.
+        */
+        unsigned long long DetectStream(Process& process, unsigned long long page);
+
+        /**
+        * Loads up to window pages following the page along the stride of its stream, skipping resident ones.
+        */
+        void ReadAhead(Process& process, unsigned long long page, unsigned long long window);
+
+        /**
+        * Marks the frames in aheadFrames_ as prefetched and demotes them in that order, so the last one is
+        * replaced first.
+        */
+        void DemoteAhead();
+
+        /**
+        * First access to a prefetched page, which saved a fault. The stream of the process moves on to it.
+        */
+        void PrefetchHit(Process& process, unsigned long long frame, unsigned long long page);
+
+        /**
+        * Queues the write-back of an evicted dirty page on the swap disk.
+        */
+        void QueueWriteBack(unsigned long long block, unsigned long long size);
+
+        /**
+        * Picks the frame for a page miss on the node. Never used frames go first, then released frames (lowest
+        * number first), then the other nodes in turn, and only when RAM is full the replacement policy of the
+        * node is asked for a victim.
+        */
+        unsigned long long AllocateFrame(const PageKey& page, unsigned int node);
+
+        /**
+        * Takes the lowest released frame of the node off its free heap. Returns false if there is none.
+        */
+        bool PopFreeFrame(NumaNode& node, unsigned long long& frame);
+
+        /**
+        * Sets the bit of the frame in the used frame bitmap, and counts it unless it was set already.
+        */
+        void MarkUsed(unsigned long long frame)
+        {
+            std::uint64_t bit = 1ULL << (frame % 64);
+            usedFrameCount_ += (usedFrames_[frame / 64] & bit) == 0;
+            usedFrames_[frame / 64] |= bit;
+        }
+
+        /**
+        * Clears the bit of the frame in the used frame bitmap. Returns 1 if it was set, else 0.
+        */
+        unsigned long long ClearUsed(unsigned long long frame)
+        {
+            std::uint64_t bit = 1ULL << (frame % 64);
+            unsigned long long wasUsed = (usedFrames_[frame / 64] & bit) != 0;
+            usedFrames_[frame / 64] &= ~bit;
+            usedFrameCount_ -= wasUsed;
+            return wasUsed;
+        }
+
+        bool IsUsed(unsigned long long frame) const { return (usedFrames_[frame / 64] >> (frame % 64) & 1) != 0; }
+
+        unsigned int NodeOf(unsigned long long frame) const
+        {
+            return nodes_.size() == 1 ? 0 : static_cast<unsigned int>(std::min<unsigned long long>(frame / nodeFrames_, nodes_.size() - 1));
+        }
+
+        /**
+        * Node a new page of the process goes to, unit is the page or huge page number.
+        */
+        unsigned int PlaceOnNode(const Process& process, unsigned long long unit) const;
+
+        /**
+        * Tells the replacement state of its node that the frame was used again, and counts the access.
+        */
+        void TouchFrame(unsigned long long frame, int core);
+
+        /**
+        * Counts a local or remote access to the frame from the core, with more than one node only.
+        */
+        void CountAccess(unsigned long long frame, int core);
+
+        /**
+        * Releases the page in the frame, or the whole huge page if the frame is its first one.
+        */
+        void ReleaseFrame(unsigned long long frame);
+
+        /**
+        * Clears one frame and hands it back to the free heap and its block.
+        */
+        void FreeFrame(unsigned long long frame);
+
+        /**
+        * Removes the page the replacement policy chose as victim from its owner. A huge page frees all
+        * its frames except the first one, which the caller reuses or frees.
+        */
+        void UnmapVictim(unsigned long long frame);
+
+        /**
+        * Drops the translation of the page in the frame from every TLB, for all processes mapping it
+        * or only for pid.
+        */
+        void ShootDown(unsigned long long frame);
+        void ShootDown(int pid, unsigned long long frame);
+
+        /**
+        * Whether a fault on the page should load the huge page around it. Counts a fallback when base
+        * pages of that huge page are already resident.
+        */
+        bool WantsHugePage(const Process& process, unsigned long long page);
+
+        /**
+        * Whether the huge page lies in a range the process passed to AdviseHugePages.
+        */
+        bool IsAdvised(const Process& process, unsigned long long hugePage) const;
+
+        /**
+        * Loads the huge page into an aligned run of free frames, preferably on the node, evicting and compacting
+        * as needed. Returns the first frame of the run.
+        */
+        unsigned long long AllocateHugePage(const PageKey& page, unsigned int node);
+
+        /**
+        * Turns a block whose frames are all free or reserved into a huge page and returns its first frame.
+        */
+        unsigned long long TakeBlock(unsigned long long block, const PageKey& page);
+
+        /**
+        * Migrates every base page out of the block to other frames of its node, so it can hold a huge page.
+        * Needs at least a block worth of free frames on the node.
+        */
+        void CompactBlock(unsigned long long block);
+
+        /**
+        * Adds or removes a frame from the resident set list of the process owning it.
+        */
+        void LinkResident(Process& process, unsigned long long frame);
+        void UnlinkResident(Process& process, unsigned long long frame);
+
+        /**
+        * Releases every frame the process owns and drops its references to shared frames. Shared frames it owns
+        * go to another process mapping them. Costs O(resident set) of that process only.
+        */
+        void ReleaseMemory(Process& process);
+
+        /**
+        * Unlinks a terminating process from the ready queue or the disk queue it is waiting in.
+        */
+        void Dequeue(Process& process);
+
+        /**
+        * True if the PID belongs to a process that hasn't terminated or turned into a zombie.
+        */
+        bool IsAlive(int pid) const;
+
+        /**
+        * Throws std::runtime_error unless every PID, frame, list and queue of a restored checkpoint agrees with
+        * the rest of the state. Linear in frames, mappings and processes.
+        */
+        void CheckRestored() const;
+
+        /**
+        * Replaces the state with a checkpoint image, member by member. Only called on a scratch SimOS, since a
+        * bad image throws half way through.
+        */
+        void DecodeCheckpoint( const void* image, std::size_t length );
 
 
     public:
         /**
          * The parameters specify number of hard disks in the simulated computer, amount of memory, and page size.
          * Disks, frame, and page enumerations all start from 0.
+         * Optionally the number of CPU cores and how work is balanced between them. Cores are numbered from 0 as well,
+         * and every call that works on the running process takes the core it runs on (core 0 by default).
         */
-        SimOS( int numberOfDisks, unsigned long long amountOfRAM, unsigned int pageSize);
+        SimOS( int numberOfDisks, unsigned long long amountOfRAM, unsigned int pageSize,
+            int numberOfCores = 1, LoadBalancing balancing = LoadBalancing::WorkStealing );
+        SimOS( int numberOfDisks, unsigned long long amountOfRAM, unsigned int pageSize, const SimOptions& options );
 
         /**
          * Creates a new process in the simulated system. The new process takes place in the ready-queue or immediately 
@@ -103,8 +610,9 @@ class SimOS
 
         /**
          * The currently running process forks a child. The child is placed in the end of the ready-queue.
+         * With SimOptions::copyOnWrite the child maps all resident pages of the parent, shared until one of them writes.
         */
-        void SimFork();
+        void SimFork( int core = 0 );
 
         /**
          * The process that is currently using the CPU terminates. Make sure you release the memory used by this process immediately. 
@@ -112,7 +620,7 @@ class SimOS
          * If its parent hasn't called wait yet, the process turns into zombie. To avoid the appearance of the orphans, the system implements 
          * the cascading termination. Cascading termination means that if a process terminates, all its descendants terminate with it.
         */
-        void SimExit();
+        void SimExit( int core = 0 );
 
         /**
          * The process wants to pause and wait for any of its child processes to terminate. Once the wait is over, the process goes to the 
@@ -120,7 +628,7 @@ class SimOS
          * the zombie-child disappears. If more than one zombie-child exists, the system uses one of them (any!) to immediately resumes the parent, 
          * while other zombies keep waiting for the next wait from the parent.
         */
-        void SimWait();
+        void SimWait( int core = 0 );
 
         /**
          * The process wants to pause and wait for any of its child processes to terminate. Once the wait is over, the process goes to the end 
@@ -132,13 +640,32 @@ class SimOS
         /**
          * Interrupt arrives from the timer signaling that the time slice of the currently running process is over.
         */
-        void TimerInterrupt();
+        void TimerInterrupt( int core = 0 );
 
         /**
          * Currently running process requests to read the specified file from the disk with a given number. 
          * The process issuing disk reading requests immediately stops using the CPU, even if the ready-queue is empty.
         */
-        void DiskReadRequest( int diskNumber, std::string fileName );
+        void DiskReadRequest( int diskNumber, std::string fileName, int core = 0 );
+
+        /**
+         * Same as above for a read of size blocks starting at block. Disks start with the head at block 0,
+         * and the disk policy decides which queued request is served next.
+        */
+        void DiskReadRequest( int diskNumber, std::string fileName, unsigned long long block,
+            unsigned long long size, int core = 0 );
+
+        /**
+         * Same as above with a name interned by InternFileName. Queuing and serving the read doesn't allocate.
+        */
+        void DiskReadRequest( int diskNumber, FileId file, unsigned long long block = 0,
+            unsigned long long size = 0, int core = 0 );
+
+        /**
+         * Id of a file name for the DiskReadRequest overload above. Ids stay valid for the life of the SimOS.
+        */
+        FileId InternFileName( std::string_view fileName ) { return fileNames_.Intern(fileName); }
+        const std::string& FileName( FileId file ) const { return fileNames_.Name(file); }
 
         /**
         * A disk with a specified number reports that a single job is completed. The served process
@@ -149,19 +676,91 @@ class SimOS
         /**
          * Currently running process wants to access the specified logical memory address. System makes sure the corresponding 
          * page is loaded in the RAM. If the corresponding page is already in the RAM, its “recently used” information is updated.
+         * With SimOptions::swapDisk a page fault blocks the process like a disk read: it queues a page-in on the swap disk
+         * and the page is loaded when that job completes. A page-in reads the run of missing pages around the faulting one,
+         * within the aligned group of pageInCluster pages, or a whole huge page.
+         * With SimOptions::readAhead a fault as many pages away from the previous fault as that one was from
+         * the fault before it loads the next pages along that stride as well, at low priority in the replacement
+         * policy. With the swap disk only sequential streams are read ahead, as part of the page-in, and every
+         * extra page a page-in reads counts as prefetched.
+         * Readahead is off with HugePageMode::Always and skips advised huge pages.
          */
-        void AccessMemoryAddress(unsigned long long address);
+        void AccessMemoryAddress(unsigned long long address, int core = 0);
+
+        /**
+         * Same as AccessMemoryAddress for a write. Writing to a page shared copy-on-write gives the writer
+         * a private copy in a frame of its own, unless it is the last process mapping the page.
+         */
+        void WriteMemoryAddress(unsigned long long address, int core = 0);
+
+        /**
+         * Seek, queue wait and queue depth counters of a disk. Throws std::out_of_range for a bad disk number.
+        */
+        DiskStats GetDiskStats( int diskNumber ) const;
+
+        /**
+         * Accesses, page faults and evictions since the SimOS was created, for comparing replacement algorithms.
+        */
+        MemoryStats GetMemoryStats() const { return memoryStats_; }
+
+        /**
+         * Private and shared resident memory of a process. Throws std::out_of_range if the process doesn't exist.
+        */
+        ResidentMemory GetResidentMemory( int pid ) const;
+
+        /**
+         * Asks for huge pages in [address, address + length) of the process running on the core, used with
+         * HugePageMode::Advised. Only huge pages lying completely inside the range count. Forked children inherit
+         * the advice. Does nothing when huge pages are off.
+         * Throws std::logic_error if the core is idle and std::out_of_range for a bad core number.
+        */
+        void AdviseHugePages( unsigned long long address, unsigned long long length, int core = 0 );
+
+        /**
+         * Hit, miss, flush and invalidation counters of the TLB of a core, all zero when the TLB is off.
+         * Throws std::out_of_range for a bad core number.
+        */
+        TLBStats GetTLBStats( int core = 0 ) const;
+
+        /**
+         * Counters of a NUMA node. Throws std::out_of_range for a bad node number.
+        */
+        NumaStats GetNumaStats( int node ) const;
+
+        /**
+         * NUMA node of a core or a frame. Throws std::out_of_range for a bad core or frame number.
+        */
+        int GetCoreNode( int core ) const;
+        int GetFrameNode( unsigned long long frame ) const;
+
+        /**
+         * Sets the node NumaPlacement::Preferred puts the pages of the process on. A new process starts on the
+         * node of its first core, forked children inherit the node of their parent.
+         * Throws std::out_of_range if the process doesn't exist or the node number is bad.
+        */
+        void SetHomeNode( int pid, int node );
+
+        /**
+         * Context switch and ready queue counters of a core. Throws std::out_of_range for a bad core number.
+        */
+        CoreStats GetCoreStats( int core = 0 ) const;
+
+        /**
+         * Sets the scheduling priority of a process, lower values run first. Used by the Priority and FairShare
+         * policies, forked children inherit it. Throws std::out_of_range if the process doesn't exist.
+        */
+        void SetPriority( int pid, int priority );
 
         /**
          * GetCPU returns the PID of the process currently using the CPU. If CPU is idle it returns NO_PROCESS
          */
-        int GetCPU();
+        int GetCPU( int core = 0 );
 
         /**
          * GetReadyQueue returns the std::deque with PIDs of processes in the ready-queue where element 
          * in front corresponds start of the ready-queue.
         */
-        std::deque<int> GetReadyQueue();
+        std::deque<int> GetReadyQueue( int core = 0 );
 
         /**
          * GetMemory returns MemoryUsage vector describing all currently used frames of RAM. Remember, 
@@ -174,15 +773,92 @@ class SimOS
          * GetDisk returns an object with PID of the process served by specified disk and the name of the file read 
          * for that process. If the disk is idle, GetDisk returns the default FileReadRequest object (with PID 0 
          * and empty string in fileName) 
+         * A swap disk writing back a page returns PID 0 with the "swap" file, and the written blocks.
         */
         FileReadRequest GetDisk( int diskNumber );
 
         /**
             * GetDiskQueue returns the I/O-queue of the specified disk starting from the “next to be served” process.
+            * With a seek ordered disk policy the next request depends on the head position, the queue is listed in arrival order then.
             * If a disk with the requested number doesn’t exist throw std::out_of_range exception.
             * If instruction is called that requires a running process, but the CPU is idle, throw std::logic_error exception.
         */
         std::deque<FileReadRequest> GetDiskQueue( int diskNumber );
+
+        /**
+         * Allocation free observers. The visitor is called for every element in the same order the
+         * matching Get method would return them. State must not be modified from inside the visitor.
+        */
+        template<typename Visitor>
+        void ForEachReady(Visitor&& visit, int core = 0) const
+        {
+            if(core < 0 || core >= static_cast<int>(cpus_.size()))
+            {
+                throw std::out_of_range("Attempt to access out of bound core index\n");
+            }
+            readyQueues_[core]->ForEach(visit);
+        }
+
+        /**
+         * The disk visitor is called as visit(process), the pending read is in ioFile, ioBlock and ioSize.
+        */
+        template<typename Visitor>
+        void ForEachDiskRequest(int diskNumber, Visitor&& visit) const
+        {
+            if(diskNumber < 0 || diskNumber >= static_cast<int>(diskQueues_.size()))
+            {
+                throw std::out_of_range("Attempt to access out of bound disk index\n");
+            }
+            diskQueues_[diskNumber]->ForEach([this, &visit](int pid) {
+                visit(*processes_->Find(pid));
+            });
+        }
+
+        /**
+         * Visits the used frames from low to high frame numbers, skipping 64 free frames at a time.
+        */
+        template<typename Visitor>
+        void ForEachUsedFrame(Visitor&& visit) const
+        {
+            for (std::size_t word = 0; word < usedFrames_.size(); ++word)
+            {
+                for (std::uint64_t bits = usedFrames_[word]; bits != 0; bits &= bits - 1)
+                    visit(physicalMemory_[word * 64 + __builtin_ctzll(bits)]);
+            }
+        }
+
+        /**
+         * Checkpoints hold the complete simulator state except the profiler counters, in a flat binary image
+         * made of raw arrays, so restoring is mostly memcpy. Checkpoint() returns the image in memory, so one
+         * prefix of a run can branch into many runs by restoring it into several SimOS objects.
+         * Restoring replaces everything, machine size and policies included, and accepts images from memory
+         * or a file, which is memory mapped. The header carries a checksum of the rest of the image. Throws
+         * std::runtime_error for a missing, foreign, truncated, corrupt or inconsistent image, in which case the
+         * SimOS keeps the state it had before the call.
+        */
+        std::vector<unsigned char> Checkpoint() const;
+        void SaveCheckpoint( const std::string& path ) const;
+        void RestoreCheckpoint( const void* image, std::size_t length );
+        void RestoreCheckpoint( const std::string& path );
+
+        /**
+         * Counters of the run so far. They only move when SimOS is built with SIMOS_PROFILING=1.
+        */
+        const SimProfiler& Profiler() const { return profiler_; }
+
+        /**
+         * Listener for dispatches and disk starts, nullptr for none. It isn't part of checkpoints.
+        */
+        void SetListener( SimListener* listener ) { listener_ = listener; }
+
+        std::size_t ReadyQueueSize( int core = 0 ) const { return readyQueues_.at(core)->size(); }
+        int NumberOfCores() const { return static_cast<int>(cpus_.size()); }
+        int NumberOfDisks() const { return static_cast<int>(diskQueues_.size()); }
+        int NextPID() const { return currentPID_; }  // assigned by the next NewProcess or SimFork
+        int NumberOfNodes() const { return static_cast<int>(nodes_.size()); }
+        std::size_t DiskQueueSize( int diskNumber ) const;
+        std::size_t PendingWriteBacks() const { return writeBacks_.size(); }
+        std::size_t UsedFrameCount() const { return usedFrameCount_; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "simProfiler.h"
+
+#include <algorithm>
+
+namespace
+{
+    void WriteHistogramJson(std::ostream& out, const Log2Histogram& histogram)
+    {
+        out << "{\"count\":" << histogram.count << ",\"mean\":" << histogram.Mean()
+            << ",\"p50\":" << histogram.Quantile(0.5) << ",\"p99\":" << histogram.Quantile(0.99)
+            << ",\"max\":" << histogram.max << "}";
+    }
+
+    void WritePagesJson(std::ostream& out, const PageCounters& counters)
+    {
+        out << "\"hits\":" << counters.hits << ",\"misses\":" << counters.misses << ",\"evictions\":" << counters.evictions;
+    }
+
+    template<typename Id>
+    void WritePagesCsv(std::ostream& out, const char* section, const Id& id, const PageCounters& counters)
+    {
+        out << section << "," << id << ",hits," << counters.hits << "\n"
+            << section << "," << id << ",misses," << counters.misses << "\n"
+            << section << "," << id << ",evictions," << counters.evictions << "\n";
+    }
+
+    void WriteHistogramListJson(std::ostream& out, const std::vector<Log2Histogram>& histograms)
+    {
+        out << "[";
+        for (std::size_t i = 0; i < histograms.size(); ++i)
+        {
+            out << (i ? "," : "");
+            WriteHistogramJson(out, histograms[i]);
+        }
+        out << "]";
+    }
+
+    template<typename Id>
+    void WriteHistogramCsv(std::ostream& out, const char* section, const Id& id, const Log2Histogram& histogram)
+    {
+        out << section << "," << id << ",count," << histogram.count << "\n"
+            << section << "," << id << ",mean," << histogram.Mean() << "\n"
+            << section << "," << id << ",p50," << histogram.Quantile(0.5) << "\n"
+            << section << "," << id << ",p99," << histogram.Quantile(0.99) << "\n"
+            << section << "," << id << ",max," << histogram.max << "\n";
+    }
+}
+
+const char* ApiCallName(ApiCall call)
+{
+    switch (call)
+    {
+        case ApiCall::NewProcess:          return "NewProcess";
+        case ApiCall::SimFork:             return "SimFork";
+        case ApiCall::SimExit:             return "SimExit";
+        case ApiCall::SimWait:             return "SimWait";
+        case ApiCall::TimerInterrupt:      return "TimerInterrupt";
+        case ApiCall::DiskReadRequest:     return "DiskReadRequest";
+        case ApiCall::DiskJobCompleted:    return "DiskJobCompleted";
+        case ApiCall::AccessMemoryAddress: return "AccessMemoryAddress";
+        case ApiCall::WriteMemoryAddress:  return "WriteMemoryAddress";
+        case ApiCall::Count: break;
+    }
+    return "";
+}
+
+std::uint64_t Log2Histogram::Quantile(double quantile) const
+{
+    if (count == 0)
+        return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(quantile * (count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < buckets.size(); ++bucket)
+    {
+        seen += buckets[bucket];
+        if (seen >= rank)
+            return bucket == 0 ? 0 : std::min<std::uint64_t>(max, bucket >= 64 ? ~0ULL : (1ULL << bucket) - 1);
+    }
+    return max;
+}
+
+SimProfiler::SimProfiler(int numberOfCores, int numberOfDisks)
+:contextSwitches_(numberOfCores),readyQueueLengths_(numberOfCores),diskQueueDepths_(numberOfDisks),diskQueueWaits_(numberOfDisks)
+{
+}
+
+void SimProfiler::WriteJson(std::ostream& out) const
+{
+    out << "{\"enabled\":" << (ENABLED ? "true" : "false") << ",\"pages\":[";
+    bool first = true;
+    for (const auto& [pid, counters] : pages_)
+    {
+        out << (first ? "" : ",") << "{\"pid\":" << pid << ",";
+        WritePagesJson(out, counters);
+        out << "}";
+        first = false;
+    }
+    out << "],\"exitedPages\":{";
+    WritePagesJson(out, exitedPages_);
+    out << "},\"contextSwitches\":[";
+    for (std::size_t core = 0; core < contextSwitches_.size(); ++core)
+        out << (core ? "," : "") << contextSwitches_[core];
+    out << "],\"readyQueueLengths\":";
+    WriteHistogramListJson(out, readyQueueLengths_);
+    out << ",\"diskQueueDepths\":";
+    WriteHistogramListJson(out, diskQueueDepths_);
+    out << ",\"diskQueueWaits\":";
+    WriteHistogramListJson(out, diskQueueWaits_);
+    out << ",\"callNanoseconds\":{";
+    for (std::size_t call = 0; call < callNanoseconds_.size(); ++call)
+    {
+        out << (call ? "," : "") << "\"" << ApiCallName(static_cast<ApiCall>(call)) << "\":";
+        WriteHistogramJson(out, callNanoseconds_[call]);
+    }
+    out << "}}\n";
+}
+
+void SimProfiler::WriteCsv(std::ostream& out) const
+{
+    out << "section,id,metric,value\n";
+    out << "profiler,,enabled," << (ENABLED ? 1 : 0) << "\n";
+    for (const auto& [pid, counters] : pages_)
+        WritePagesCsv(out, "pages", pid, counters);
+    WritePagesCsv(out, "exitedPages", "", exitedPages_);
+    for (std::size_t core = 0; core < contextSwitches_.size(); ++core)
+    {
+        out << "contextSwitches," << core << ",count," << contextSwitches_[core] << "\n";
+        WriteHistogramCsv(out, "readyQueueLength", core, readyQueueLengths_[core]);
+    }
+    for (std::size_t disk = 0; disk < diskQueueDepths_.size(); ++disk)
+    {
+        WriteHistogramCsv(out, "diskQueueDepth", disk, diskQueueDepths_[disk]);
+        WriteHistogramCsv(out, "diskQueueWait", disk, diskQueueWaits_[disk]);
+    }
+    for (std::size_t call = 0; call < callNanoseconds_.size(); ++call)
+        WriteHistogramCsv(out, "callNanoseconds", ApiCallName(static_cast<ApiCall>(call)), callNanoseconds_[call]);
+}
@@ -0,0 +1,180 @@
+#ifndef SIM_PROFILER_H
+#define SIM_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <vector>
+
+/**
+ * Build with -DSIMOS_PROFILING=1 to turn the counters on. Otherwise every recording call is an empty
+ * inline function the compiler drops, and the dumps only report that profiling is off.
+ */
+#ifndef SIMOS_PROFILING
+#define SIMOS_PROFILING 0
+#endif
+
+/**
+ * Public SimOS calls whose wall clock cost is measured.
+ */
+enum class ApiCall
+{
+    NewProcess,
+    SimFork,
+    SimExit,
+    SimWait,
+    TimerInterrupt,
+    DiskReadRequest,
+    DiskJobCompleted,
+    AccessMemoryAddress,
+    WriteMemoryAddress,
+    Count
+};
+
+const char* ApiCallName(ApiCall call);
+
+/**
+ * Histogram with power of two buckets: bucket b counts values in [2^(b-1), 2^b), bucket 0 counts zeros.
+ * Adding a value is a handful of instructions and never allocates.
+ */
+struct Log2Histogram
+{
+    std::array<std::uint64_t, 65> buckets {};
+    std::uint64_t count {0};
+    std::uint64_t sum {0};
+    std::uint64_t max {0};
+
+    void Add(std::uint64_t value)
+    {
+        ++buckets[value == 0 ? 0 : 64 - __builtin_clzll(value)];
+        ++count;
+        sum += value;
+        max = value > max ? value : max;
+    }
+
+    double Mean() const { return count == 0 ? 0.0 : static_cast<double>(sum) / count; }
+
+    /**
+     * Upper bound of the bucket holding the given quantile (0 to 1).
+    */
+    std::uint64_t Quantile(double quantile) const;
+};
+
+struct PageCounters
+{
+    std::uint64_t hits {0};
+    std::uint64_t misses {0};
+    std::uint64_t evictions {0};   // pages of this process that were replaced to make room for another page
+};
+
+/**
+ * Counters and histograms SimOS fills while it runs. Per process counters are kept by PID while the
+ * process lives and folded into one total for the exited processes when its PID is released, so they
+ * take memory for the live processes only, however many PIDs the run goes through.
+ */
+class SimProfiler
+{
+    private:
+        std::map<int, PageCounters> pages_;           // live processes that touched memory, by PID
+        PageCounters exitedPages_;
+        std::vector<std::uint64_t> contextSwitches_;     // per core
+        std::vector<Log2Histogram> readyQueueLengths_;   // per core, sampled on every dispatch
+        std::vector<Log2Histogram> diskQueueDepths_;     // per disk, sampled on every request and completion
+        std::vector<Log2Histogram> diskQueueWaits_;      // per disk, requests served ahead of each request
+        std::array<Log2Histogram, static_cast<std::size_t>(ApiCall::Count)> callNanoseconds_;
+
+        PageCounters& Pages(int pid) { return pages_[pid]; }
+
+    public:
+        static constexpr bool ENABLED = SIMOS_PROFILING != 0;
+
+        SimProfiler(int numberOfCores, int numberOfDisks);
+
+        void PageHit(int pid) { if constexpr (ENABLED) ++Pages(pid).hits; }
+        void PageMiss(int pid) { if constexpr (ENABLED) ++Pages(pid).misses; }
+        void PageEvicted(int pid) { if constexpr (ENABLED) ++Pages(pid).evictions; }
+
+        /**
+         * The PID is released, its page counters move to the exited total.
+        */
+        void ProcessReleased(int pid)
+        {
+            if constexpr (ENABLED)
+            {
+                auto found = pages_.find(pid);
+                if (found == pages_.end())
+                    return;
+                exitedPages_.hits += found->second.hits;
+                exitedPages_.misses += found->second.misses;
+                exitedPages_.evictions += found->second.evictions;
+                pages_.erase(found);
+            }
+        }
+
+        /**
+         * A core starts running a process, with readyLength processes left in its run queue.
+        */
+        void Dispatch(int core, std::size_t readyLength)
+        {
+            if constexpr (ENABLED)
+            {
+                ++contextSwitches_[core];
+                readyQueueLengths_[core].Add(readyLength);
+            }
+        }
+
+        void DiskQueueDepth(int disk, std::size_t depth) { if constexpr (ENABLED) diskQueueDepths_[disk].Add(depth); }
+        void DiskQueueWait(int disk, std::uint64_t wait) { if constexpr (ENABLED) diskQueueWaits_[disk].Add(wait); }
+
+        /**
+         * Times a public call from construction to destruction. Costs nothing when profiling is off.
+        */
+        class CallTimer
+        {
+            private:
+                SimProfiler* profiler_;
+                ApiCall call_;
+                std::chrono::steady_clock::time_point start_;
+
+            public:
+                CallTimer(SimProfiler& profiler, ApiCall call) : profiler_(&profiler), call_(call)
+                {
+                    if constexpr (ENABLED)
+                        start_ = std::chrono::steady_clock::now();
+                }
+
+                ~CallTimer()
+                {
+                    if constexpr (ENABLED)
+                    {
+                        auto elapsed = std::chrono::steady_clock::now() - start_;
+                        profiler_->callNanoseconds_[static_cast<std::size_t>(call_)].Add(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                    }
+                }
+
+                CallTimer(const CallTimer&) = delete;
+                CallTimer& operator=(const CallTimer&) = delete;
+        };
+
+        CallTimer Time(ApiCall call) { return CallTimer(*this, call); }
+
+        const std::map<int, PageCounters>& Pages() const { return pages_; }
+        const PageCounters& ExitedPages() const { return exitedPages_; }
+        const std::vector<std::uint64_t>& ContextSwitches() const { return contextSwitches_; }
+        const std::vector<Log2Histogram>& ReadyQueueLengths() const { return readyQueueLengths_; }
+        const std::vector<Log2Histogram>& DiskQueueDepths() const { return diskQueueDepths_; }
+        const std::vector<Log2Histogram>& DiskQueueWaits() const { return diskQueueWaits_; }
+        const Log2Histogram& CallNanoseconds(ApiCall call) const { return callNanoseconds_[static_cast<std::size_t>(call)]; }
+
+        /**
+         * Writes every counter as one JSON object, or as CSV rows of section,id,metric,value.
+         * Processes that never touched memory are left out, exited ones are summed up under exitedPages.
+        */
+        void WriteJson(std::ostream& out) const;
+        void WriteCsv(std::ostream& out) const;
+};
+
+#endif
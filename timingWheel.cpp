@@ -0,0 +1,102 @@
+#include "timingWheel.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+TimingWheel::TimingWheel()
+{
+    std::fill(std::begin(heads_), std::end(heads_), NIL);
+    std::fill(std::begin(tails_), std::end(tails_), NIL);
+}
+
+void TimingWheel::Link(unsigned long long node)
+{
+    unsigned long long differs = nodes_[node].event.time ^ cursor_;
+    unsigned int level = differs == 0 ? 0 : (63 - __builtin_clzll(differs)) / SLOT_BITS;
+    unsigned int slot = (nodes_[node].event.time >> (level * SLOT_BITS)) & (SLOTS - 1);
+    unsigned int index = level * SLOTS + slot;
+
+    nodes_[node].next = NIL;
+    if (heads_[index] == NIL)
+        heads_[index] = node;
+    else
+        nodes_[tails_[index]].next = node;
+    tails_[index] = node;
+    occupied_[level] |= 1ULL << slot;
+}
+
+void TimingWheel::Schedule(const TimedEvent& event)
+{
+    if (event.time < cursor_)
+    {
+        throw std::invalid_argument("Event is due before the current time of the wheel\n");
+    }
+    unsigned long long node = freeNodes_;
+    if (node == NIL)
+    {
+        node = nodes_.size();
+        nodes_.push_back(Node{event, NIL});
+    }
+    else
+    {
+        freeNodes_ = nodes_[node].next;
+        nodes_[node].event = event;
+    }
+    Link(node);
+    ++size_;
+}
+
+bool TimingWheel::PopNext(unsigned long long limit, TimedEvent& event)
+{
+    for (;;)
+    {
+        if (occupied_[0] != 0)
+        {
+            // Every event on level 0 shares all but the low digit with the cursor
+            unsigned int slot = __builtin_ctzll(occupied_[0]);
+            unsigned long long time = (cursor_ & ~static_cast<unsigned long long>(SLOTS - 1)) | slot;
+            if (time > limit)
+                return false;
+            unsigned long long node = heads_[slot];
+            heads_[slot] = nodes_[node].next;
+            if (heads_[slot] == NIL)
+            {
+                tails_[slot] = NIL;
+                occupied_[0] &= ~(1ULL << slot);
+            }
+            event = nodes_[node].event;
+            nodes_[node].next = freeNodes_;
+            freeNodes_ = node;
+            cursor_ = time;
+            --size_;
+            return true;
+        }
+
+        unsigned int level = 1;
+        while (level < LEVELS && occupied_[level] == 0)
+            ++level;
+        if (level == LEVELS)
+            return false;
+
+        // Move the cursor to the start of the first occupied slot and spread its events over the lower levels
+        unsigned int shift = level * SLOT_BITS;
+        unsigned int slot = __builtin_ctzll(occupied_[level]);
+        unsigned long long above = shift + SLOT_BITS >= 64 ? 0 : cursor_ >> (shift + SLOT_BITS) << (shift + SLOT_BITS);
+        unsigned long long start = above | static_cast<unsigned long long>(slot) << shift;
+        if (start > limit)
+            return false;
+        cursor_ = start;
+
+        unsigned int index = level * SLOTS + slot;
+        unsigned long long node = heads_[index];
+        heads_[index] = NIL;
+        tails_[index] = NIL;
+        occupied_[level] &= ~(1ULL << slot);
+        while (node != NIL)
+        {
+            unsigned long long next = nodes_[node].next;
+            Link(node);
+            node = next;
+        }
+    }
+}
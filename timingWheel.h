@@ -0,0 +1,67 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Event on the simulated clock. kind, unit and tag are up to the user of the wheel.
+ */
+struct TimedEvent
+{
+    unsigned long long time {0};
+    unsigned long long tag {0};
+    int unit {0};
+    unsigned char kind {0};
+};
+
+/**
+ * Hierarchical timing wheel over 64 bit times. Level l has 64 slots of 64^l ticks each. An event goes to the
+ * level of the highest 6 bit digit in which its time differs from the cursor, so level 0 only holds events
+ * of the current 64 ticks. When level 0 runs empty the first slot of the next level up is cascaded into the
+ * lower levels. Scheduling is O(1) and every event is cascaded at most once per level. Occupancy bitmaps find
+ * the next slot with one instruction. Events due at the same time come out in the order they were scheduled.
+ * Events live in a pool threaded by free lists, so a long run doesn't allocate.
+ */
+class TimingWheel
+{
+    private:
+        static constexpr unsigned int SLOT_BITS = 6;
+        static constexpr unsigned int SLOTS = 1U << SLOT_BITS;
+        static constexpr unsigned int LEVELS = (64 + SLOT_BITS - 1) / SLOT_BITS;
+        static constexpr unsigned long long NIL = ~0ULL;
+
+        struct Node
+        {
+            TimedEvent event;
+            unsigned long long next;
+        };
+
+        std::vector<Node> nodes_;
+        unsigned long long freeNodes_ {NIL};
+        unsigned long long heads_[LEVELS * SLOTS];
+        unsigned long long tails_[LEVELS * SLOTS];
+        std::uint64_t occupied_[LEVELS] {};
+        unsigned long long cursor_ {0};     // no event is earlier, only moves forward
+        unsigned long long size_ {0};
+
+        void Link(unsigned long long node);
+
+    public:
+        TimingWheel();
+
+        /**
+         * Throws std::invalid_argument if the event is due before an event that already came out.
+        */
+        void Schedule(const TimedEvent& event);
+
+        /**
+         * Takes the earliest event if it is due at or before limit, returns false if there is none.
+        */
+        bool PopNext(unsigned long long limit, TimedEvent& event);
+
+        unsigned long long size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+};
+
+#endif
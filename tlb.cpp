@@ -0,0 +1,91 @@
+#include "tlb.h"
+#include "processTable.h"
+
+TLB::TLB(const TLBConfig& config, unsigned long long hugeFrames)
+:entries_(static_cast<std::size_t>(config.sets) * config.ways),setMask_{config.sets - 1ULL},ways_{config.ways},
+tagged_{config.tagged},hugeFrames_{hugeFrames}
+{
+}
+
+TLB::Entry* TLB::Find(int pid, unsigned long long page, bool huge)
+{
+    Entry* set = &entries_[(page & setMask_) * ways_];
+    for (unsigned int way = 0; way < ways_; ++way)
+    {
+        if (set[way].page == page && set[way].PID == pid && set[way].huge == huge && set[way].frame != NO_FRAME)
+            return &set[way];
+    }
+    return nullptr;
+}
+
+void TLB::Fill(int pid, unsigned long long page, bool huge, unsigned long long frame)
+{
+    Entry* set = &entries_[(page & setMask_) * ways_];
+    Entry* victim = &set[0];
+    for (unsigned int way = 0; way < ways_; ++way)
+    {
+        if (set[way].frame == NO_FRAME)
+        {
+            victim = &set[way];
+            break;
+        }
+        if (set[way].lastUse < victim->lastUse)
+            victim = &set[way];
+    }
+    *victim = Entry{page, frame, ++clock_, pid, huge};
+}
+
+void TLB::Invalidate(int pid, unsigned long long page, bool huge)
+{
+    Entry* entry = Find(pid, page, huge);
+    if (entry != nullptr)
+    {
+        entry->frame = NO_FRAME;
+        ++stats_.invalidations;
+    }
+}
+
+void TLB::SwitchTo(int pid)
+{
+    // An idle core keeps the last address space, like a lazy TLB switch.
+    if (pid == NO_PROCESS || pid == lastPID_)
+        return;
+    if (!tagged_ && lastPID_ != NO_PROCESS)
+        Flush();
+    lastPID_ = pid;
+}
+
+void TLB::Flush()
+{
+    for (Entry& entry : entries_)
+        entry.frame = NO_FRAME;
+    ++stats_.flushes;
+}
+
+void TLB::Save(CheckpointWriter& out) const
+{
+    out.Write(setMask_);
+    out.Write(ways_);
+    out.Write(tagged_);
+    out.Write(hugeFrames_);
+    out.Write(clock_);
+    out.Write(lastPID_);
+    out.Write(stats_);
+    out.WriteVector(entries_);
+}
+
+void TLB::Load(CheckpointReader& in, unsigned long long amountOfFrames)
+{
+    setMask_ = in.Read<unsigned long long>();
+    ways_ = in.Read<unsigned int>();
+    tagged_ = in.ReadBool();
+    hugeFrames_ = in.Read<unsigned long long>();
+    clock_ = in.Read<unsigned long long>();
+    lastPID_ = in.Read<int>();
+    stats_ = in.Read<TLBStats>();
+    in.ReadVector(entries_);
+    CheckCheckpoint(ways_ != 0 && hugeFrames_ != 0 && (setMask_ & (setMask_ + 1)) == 0 && setMask_ < entries_.size()
+        && entries_.size() % ways_ == 0 && entries_.size() / ways_ == setMask_ + 1);
+    for (const Entry& entry : entries_)
+        CheckCheckpoint(IsBool(entry.huge) && (entry.frame == NO_FRAME || entry.frame < amountOfFrames));
+}
@@ -0,0 +1,110 @@
+#ifndef TLB_H
+#define TLB_H
+
+#include <vector>
+
+#include "pageTable.h"
+#include "checkpoint.h"
+
+/**
+ * Shape of the per core TLBs. sets must be a power of two, 0 leaves the TLBs out.
+ * tagged: entries carry the PID as address space ID and survive context switches.
+ * Otherwise the TLB is flushed whenever its core switches to another process.
+ */
+struct TLBConfig
+{
+    unsigned int sets {0};
+    unsigned int ways {4};
+    bool tagged {true};
+};
+
+/**
+ * Per core counters. invalidations counts entries dropped by evictions, migrations and exits.
+ */
+struct TLBStats
+{
+    unsigned long long hits {0};
+    unsigned long long misses {0};
+    unsigned long long flushes {0};
+    unsigned long long invalidations {0};
+
+    double HitRatio() const { return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses); }
+};
+
+/**
+ * Set associative translation cache of one core, LRU within a set. Sets are indexed by the low bits of the
+ * page number like in hardware. Base and huge pages share the entries, a huge page entry covers the whole
+ * huge page and is looked up by its huge page number. Entries hold the frame the replacement policy
+ * tracks, the first frame for a huge page.
+ */
+class TLB
+{
+    private:
+        struct Entry
+        {
+            unsigned long long page {0};
+            unsigned long long frame {NO_FRAME};
+            unsigned long long lastUse {0};
+            int PID {0};
+            bool huge {false};
+        };
+
+        std::vector<Entry> entries_;
+        unsigned long long setMask_;
+        unsigned int ways_;
+        bool tagged_;
+        unsigned long long hugeFrames_;   // base pages per huge page, 1 without huge pages
+        unsigned long long clock_ {0};
+        int lastPID_ {0};
+        TLBStats stats_;
+
+        Entry* Find(int pid, unsigned long long page, bool huge);
+
+    public:
+        TLB(const TLBConfig& config, unsigned long long hugeFrames);
+
+        /**
+         * Returns the cached frame for the page or NO_FRAME, and counts the hit or miss.
+        */
+        unsigned long long Lookup(int pid, unsigned long long page)
+        {
+            Entry* entry = Find(pid, page, false);
+            if (entry == nullptr && hugeFrames_ > 1)
+                entry = Find(pid, page / hugeFrames_, true);
+            if (entry == nullptr)
+            {
+                ++stats_.misses;
+                return NO_FRAME;
+            }
+            ++stats_.hits;
+            entry->lastUse = ++clock_;
+            return entry->frame;
+        }
+
+        /**
+         * Caches a translation after a miss. page is the huge page number for a huge page.
+        */
+        void Fill(int pid, unsigned long long page, bool huge, unsigned long long frame);
+
+        /**
+         * Drops the translation if it is cached.
+        */
+        void Invalidate(int pid, unsigned long long page, bool huge);
+
+        /**
+         * The core now runs pid. Flushes an untagged TLB if the address space changed, idling doesn't count.
+        */
+        void SwitchTo(int pid);
+
+        void Flush();
+
+        const TLBStats& Stats() const { return stats_; }
+
+        /**
+         * Writes or restores the TLB. Load throws std::runtime_error unless every cached frame is below amountOfFrames.
+        */
+        void Save(CheckpointWriter& out) const;
+        void Load(CheckpointReader& in, unsigned long long amountOfFrames);
+};
+
+#endif
@@ -0,0 +1,315 @@
+#include "traceReplay.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TraceFile::TraceFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open trace " + path + "\n");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(TraceHeader))
+    {
+        close(fd);
+        throw std::runtime_error("Trace " + path + " is too short\n");
+    }
+    length_ = info.st_size;
+    void* mapping = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Cannot map trace " + path + "\n");
+    }
+    data_ = static_cast<const unsigned char*>(mapping);
+    madvise(mapping, length_, MADV_SEQUENTIAL);
+
+    header_ = reinterpret_cast<const TraceHeader*>(data_);
+    std::size_t eventsEnd = sizeof(TraceHeader) + header_->eventCount * sizeof(TraceEvent);
+    if (std::memcmp(header_->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header_->version == 0 || header_->version > TRACE_VERSION
+        || header_->eventCount > length_ / sizeof(TraceEvent) || eventsEnd > length_)
+    {
+        munmap(mapping, length_);
+        throw std::runtime_error("Trace " + path + " is not a valid trace file\n");
+    }
+    events_ = reinterpret_cast<const TraceEvent*>(data_ + sizeof(TraceHeader));
+
+    std::size_t offset = eventsEnd;
+    fileNames_.reserve(header_->stringCount);
+    for (std::uint64_t i = 0; i < header_->stringCount; ++i)
+    {
+        std::uint32_t size;
+        if (offset + sizeof(size) > length_)
+            break;
+        std::memcpy(&size, data_ + offset, sizeof(size));
+        offset += sizeof(size);
+        if (offset + size > length_)
+            break;
+        fileNames_.emplace_back(reinterpret_cast<const char*>(data_ + offset), size);
+        offset += size;
+    }
+    if (fileNames_.size() != header_->stringCount)
+    {
+        munmap(mapping, length_);
+        throw std::runtime_error("Trace " + path + " has a truncated string table\n");
+    }
+}
+
+TraceFile::~TraceFile()
+{
+    munmap(const_cast<unsigned char*>(data_), length_);
+}
+
+std::uint64_t ConvertTextTrace(std::istream& input, const std::string& outputPath)
+{
+    TraceHeader header{};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.numberOfDisks = 1;
+    header.amountOfRAM = 1ULL << 30;
+    header.pageSize = 4096;
+    header.numberOfCores = 1;
+
+    // Events are streamed to the file behind a placeholder header, only the string table is kept in memory
+    std::ofstream output(outputPath, std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+        throw std::runtime_error("Cannot write trace " + outputPath + "\n");
+    }
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, std::uint64_t> stringIndex;
+
+    std::string line;
+    for (unsigned long long lineNumber = 1; std::getline(input, line); ++lineNumber)
+    {
+        auto comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        std::istringstream fields(line);
+        std::string command;
+        if (!(fields >> command))
+            continue;
+
+        TraceEvent event{};
+        bool valid = true;
+        if (command[0] == '@')
+        {
+            std::istringstream coreField(command.substr(1));
+            valid = static_cast<bool>(coreField >> event.core) && static_cast<bool>(fields >> command);
+        }
+
+        if (!valid)
+            command.clear();
+        if (command == "config")
+        {
+            valid = header.eventCount == 0 && static_cast<bool>(fields >> header.numberOfDisks >> header.amountOfRAM >> header.pageSize);
+            if (valid)
+            {
+                unsigned int cores;
+                if (fields >> cores)
+                    header.numberOfCores = cores;
+                continue;
+            }
+        }
+        else if (command == "new")
+            event.op = TraceOp::NewProcess;
+        else if (command == "fork")
+            event.op = TraceOp::SimFork;
+        else if (command == "exit")
+            event.op = TraceOp::SimExit;
+        else if (command == "wait")
+            event.op = TraceOp::SimWait;
+        else if (command == "timer")
+            event.op = TraceOp::TimerInterrupt;
+        else if (command == "done")
+        {
+            event.op = TraceOp::DiskJobCompleted;
+            valid = static_cast<bool>(fields >> event.unit);
+        }
+        else if (command == "access" || command == "write")
+        {
+            event.op = command == "access" ? TraceOp::AccessMemoryAddress : TraceOp::WriteMemoryAddress;
+            valid = static_cast<bool>(fields >> event.arg);
+        }
+        else if (command == "read")
+        {
+            event.op = TraceOp::DiskReadRequest;
+            std::string fileName;
+            valid = static_cast<bool>(fields >> event.unit >> fileName);
+            if (valid)
+            {
+                auto found = stringIndex.emplace(fileName, strings.size());
+                if (found.second)
+                    strings.push_back(fileName);
+                event.arg = found.first->second;
+
+                TraceExtent extent{};
+                extent.op = TraceOp::ReadExtent;
+                unsigned long long size = 0;
+                if (fields >> extent.block)
+                {
+                    valid = !(fields >> size) ? fields.eof() : size <= UINT32_MAX;
+                    extent.size = static_cast<std::uint32_t>(size);
+                    output.write(reinterpret_cast<const char*>(&extent), sizeof(extent));
+                    ++header.eventCount;
+                }
+                else
+                    valid = fields.eof();
+            }
+        }
+        else
+            valid = false;
+
+        if (!valid)
+        {
+            output.close();
+            std::remove(outputPath.c_str());
+            throw std::runtime_error("Malformed trace line " + std::to_string(lineNumber) + ": " + line + "\n");
+        }
+        output.write(reinterpret_cast<const char*>(&event), sizeof(event));
+        ++header.eventCount;
+    }
+
+    for (const auto& name : strings)
+    {
+        std::uint32_t size = name.size();
+        output.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        output.write(name.data(), size);
+    }
+    header.stringCount = strings.size();
+    output.seekp(0);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!output)
+    {
+        output.close();
+        std::remove(outputPath.c_str());
+        throw std::runtime_error("Failed writing trace " + outputPath + "\n");
+    }
+    return header.eventCount;
+}
+
+namespace
+{
+    constexpr std::uint64_t REPLAY_BATCH{ 4096 };
+
+    /**
+     * Replays events [begin, end), counting the ReadExtent records in extents. Returns the index of the first
+     * event that threw, or end.
+    */
+    std::uint64_t ReplayBatch(SimOS& sim, const TraceEvent* events, std::uint64_t begin, std::uint64_t end,
+        const std::vector<FileId>& fileIds, std::uint64_t& extents)
+    {
+        std::uint64_t i = begin;
+        try
+        {
+            for (; i < end; ++i)
+            {
+                const TraceEvent& event = events[i];
+                switch (event.op)
+                {
+                    case TraceOp::NewProcess:          sim.NewProcess(); break;
+                    case TraceOp::SimFork:             sim.SimFork(event.core); break;
+                    case TraceOp::SimExit:             sim.SimExit(event.core); break;
+                    case TraceOp::SimWait:             sim.SimWait(event.core); break;
+                    case TraceOp::TimerInterrupt:      sim.TimerInterrupt(event.core); break;
+                    case TraceOp::DiskReadRequest:
+                    {
+                        TraceExtent extent{};
+                        if (i > 0 && events[i - 1].op == TraceOp::ReadExtent)
+                            std::memcpy(&extent, &events[i - 1], sizeof(extent));
+                        sim.DiskReadRequest(event.unit, fileIds.at(event.arg), extent.block, extent.size, event.core);
+                        break;
+                    }
+                    case TraceOp::DiskJobCompleted:    sim.DiskJobCompleted(event.unit); break;
+                    case TraceOp::AccessMemoryAddress: sim.AccessMemoryAddress(event.arg, event.core); break;
+                    case TraceOp::WriteMemoryAddress:  sim.WriteMemoryAddress(event.arg, event.core); break;
+                    case TraceOp::ReadExtent:          ++extents; break;
+                }
+            }
+        }
+        catch (const std::logic_error&)
+        {
+            // std::out_of_range derives from std::logic_error as well
+        }
+        return i;
+    }
+
+    /**
+     * Names are interned once up front so disk reads don't touch strings during the replay.
+    */
+    std::vector<FileId> InternFileNames(SimOS& sim, const TraceFile& trace)
+    {
+        std::vector<FileId> fileIds;
+        fileIds.reserve(trace.FileNames().size());
+        for (const auto& name : trace.FileNames())
+            fileIds.push_back(sim.InternFileName(name));
+        return fileIds;
+    }
+
+    /**
+     * Replays events [begin, end), skipping the ones that throw, and adds the operations it dispatched to stats.
+    */
+    void ReplayRange(SimOS& sim, const TraceEvent* events, std::uint64_t begin, std::uint64_t end,
+        const std::vector<FileId>& fileIds, ReplayStats& stats)
+    {
+        std::uint64_t extents = 0;
+        stats.events += end - begin;
+        while (begin < end)
+        {
+            std::uint64_t stopped = ReplayBatch(sim, events, begin, end, fileIds, extents);
+            if (stopped < end)
+            {
+                ++stats.rejected;
+                ++stopped;
+            }
+            begin = stopped;
+        }
+        stats.events -= extents;
+    }
+}
+
+ReplayStats ReplayTrace(SimOS& sim, const TraceFile& trace)
+{
+    ReplayStats stats;
+    const std::uint64_t count = trace.EventCount();
+    std::vector<FileId> fileIds = InternFileNames(sim, trace);
+
+    auto start = std::chrono::steady_clock::now();
+    ReplayRange(sim, trace.Events(), 0, count, fileIds, stats);
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+std::vector<ReplayStats> ReplayTrace(const std::vector<SimOS*>& sims, const TraceFile& trace)
+{
+    std::vector<ReplayStats> stats(sims.size());
+    std::vector<std::vector<FileId>> fileIds;
+    for (SimOS* sim : sims)
+        fileIds.push_back(InternFileNames(*sim, trace));
+
+    const std::uint64_t count = trace.EventCount();
+    for (std::uint64_t begin = 0; begin < count; begin += REPLAY_BATCH)
+    {
+        std::uint64_t end = std::min(begin + REPLAY_BATCH, count);
+        for (std::size_t i = 0; i < sims.size(); ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            ReplayRange(*sims[i], trace.Events(), begin, end, fileIds[i], stats[i]);
+            stats[i].seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,137 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <istream>
+
+#include "simOS.h"
+
+/**
+ * Binary trace layout (native byte order):
+ *   TraceHeader
+ *   TraceEvent[eventCount]
+ *   string table: stringCount entries of (uint32 length, bytes)
+ * File names of disk reads are stored once in the string table and events refer to them by index.
+ * Version 2 adds ReadExtent records, version 1 traces are read as well.
+ */
+enum class TraceOp : std::uint8_t
+{
+    NewProcess,
+    SimFork,
+    SimExit,
+    SimWait,
+    TimerInterrupt,
+    DiskReadRequest,    // unit = disk, arg = string table index, block and size 0 unless a ReadExtent precedes it
+    DiskJobCompleted,   // unit = disk
+    AccessMemoryAddress, // arg = logical address
+    WriteMemoryAddress,  // arg = logical address
+    ReadExtent           // a TraceExtent for the DiskReadRequest right after it, does nothing on its own
+};
+
+struct TraceHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t numberOfDisks;
+    std::uint64_t amountOfRAM;
+    std::uint32_t pageSize;
+    std::uint32_t numberOfCores;   // 0 in traces written before multi-core support, meaning 1
+    std::uint64_t eventCount;
+    std::uint64_t stringCount;
+};
+
+struct TraceEvent
+{
+    TraceOp op;
+    std::uint8_t flags;
+    std::uint16_t unit;
+    std::uint16_t core;
+    std::uint16_t reserved;
+    std::uint64_t arg;
+};
+
+static_assert(sizeof(TraceEvent) == 16, "TraceEvent must stay 16 bytes");
+
+/**
+ * Layout of a ReadExtent record in the event array, so reads keep the 16 byte events of everything else.
+ */
+struct TraceExtent
+{
+    TraceOp op;
+    std::uint8_t flags;
+    std::uint16_t reserved;
+    std::uint32_t size;
+    std::uint64_t block;
+};
+
+static_assert(sizeof(TraceExtent) == sizeof(TraceEvent), "TraceExtent must fill one event slot");
+
+constexpr char TRACE_MAGIC[8]{ 'S', 'I', 'M', 'T', 'R', 'A', 'C', 'E' };
+constexpr std::uint32_t TRACE_VERSION{ 2 };
+
+/**
+ * Read-only view of a binary trace file. The file is memory mapped, events are used in place.
+ * Throws std::runtime_error if the file can't be opened or isn't a valid trace.
+ */
+class TraceFile
+{
+    private:
+        const unsigned char* data_{nullptr};
+        std::size_t length_{0};
+        const TraceHeader* header_{nullptr};
+        const TraceEvent* events_{nullptr};
+        std::vector<std::string> fileNames_;
+
+    public:
+        explicit TraceFile(const std::string& path);
+        ~TraceFile();
+
+        TraceFile(const TraceFile&) = delete;
+        TraceFile& operator=(const TraceFile&) = delete;
+
+        const TraceHeader& Header() const { return *header_; }
+        const TraceEvent* Events() const { return events_; }
+        std::uint64_t EventCount() const { return header_->eventCount; }
+        const std::vector<std::string>& FileNames() const { return fileNames_; }
+};
+
+/**
+ * Converts the text trace format into the binary one. One event per line, '#' starts a comment:
+ *   config <numberOfDisks> <amountOfRAM> <pageSize> [numberOfCores]   (optional, must come first)
+ *   new | fork | exit | wait | timer
+ *   read <disk> <fileName> [block [size]]   (size below 2^32, written as a ReadExtent before the read)
+ *   done <disk>
+ *   access <address>
+ *   write <address>
+ * Events for a core other than 0 are prefixed with @<core>, e.g. "@2 timer".
+ * Events are streamed to the file as they are parsed, so memory doesn't grow with the length of the trace.
+ * Returns the number of events written, ReadExtent records included. Throws std::runtime_error naming the line on a parse error,
+ * or the file when writing it fails, after removing the partly written file.
+ */
+std::uint64_t ConvertTextTrace(std::istream& input, const std::string& outputPath);
+
+struct ReplayStats
+{
+    std::uint64_t events{0};     // operations dispatched to SimOS, ReadExtent records are part of their read
+    std::uint64_t rejected{0};   // events that made SimOS throw, e.g. fork with an idle CPU
+    double seconds{0.0};
+
+    double EventsPerSecond() const { return seconds > 0.0 ? events / seconds : 0.0; }
+};
+
+/**
+ * Feeds every event of the trace to the simulator in order, in one pass over the mapping straight to the
+ * SimOS calls, without virtual calls or per event allocations. Events that make SimOS throw are skipped.
+ */
+ReplayStats ReplayTrace(SimOS& sim, const TraceFile& trace);
+
+/**
+ * Replays the trace into several simulators in a single pass: every batch of events is fed to all of them
+ * before the next one is read, e.g. to compare replacement algorithms or RAM sizes on the same workload.
+ * seconds is the time spent in each simulator.
+ */
+std::vector<ReplayStats> ReplayTrace(const std::vector<SimOS*>& sims, const TraceFile& trace);
+
+#endif
@@ -0,0 +1,226 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "parameterSweep.h"
+#include "traceReplay.h"
+
+namespace
+{
+    void PrintUsage()
+    {
+        std::cerr << "usage: traceTool convert <text trace> <binary trace>\n"
+                  << "       traceTool replay <binary trace> [numberOfDisks amountOfRAM pageSize [numberOfCores]]\n"
+                  << "       traceTool profile <binary trace> json|csv\n"
+                  << "       traceTool faults <binary trace> [--huge hugePageSize] [--readahead window] [amountOfRAM ...]\n"
+                  << "       traceTool tlb <binary trace> sets ways [asid|flush]\n"
+                  << "       traceTool sweep <binary trace> numberOfDisks,... amountOfRAM,... pageSize,... [threads]\n";
+    }
+
+    /**
+     * Splits a comma separated list of numbers.
+    */
+    template <typename Number>
+    std::vector<Number> ParseList(const std::string& list)
+    {
+        std::vector<Number> numbers;
+        std::size_t begin = 0;
+        while (begin <= list.size())
+        {
+            std::size_t end = std::min(list.find(',', begin), list.size());
+            numbers.push_back(static_cast<Number>(std::stoull(list.substr(begin, end - begin))));
+            begin = end + 1;
+        }
+        return numbers;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        PrintUsage();
+        return 2;
+    }
+    std::string command = argv[1];
+    try
+    {
+        if (command == "convert" && argc == 4)
+        {
+            std::ifstream input(argv[2]);
+            if (!input)
+            {
+                std::cerr << "Cannot read " << argv[2] << "\n";
+                return 1;
+            }
+            std::uint64_t events = ConvertTextTrace(input, argv[3]);
+            std::cout << "Wrote " << events << " events to " << argv[3] << "\n";
+            return 0;
+        }
+        if (command == "replay" && (argc == 3 || argc == 6 || argc == 7))
+        {
+            TraceFile trace(argv[2]);
+            int disks = trace.Header().numberOfDisks;
+            unsigned long long ram = trace.Header().amountOfRAM;
+            unsigned int pageSize = trace.Header().pageSize;
+            int cores = std::max<int>(1, trace.Header().numberOfCores);
+            if (argc >= 6)
+            {
+                disks = std::stoi(argv[3]);
+                ram = std::stoull(argv[4]);
+                pageSize = std::stoul(argv[5]);
+            }
+            if (argc == 7)
+            {
+                cores = std::stoi(argv[6]);
+            }
+            SimOS sim(disks, ram, pageSize, cores);
+            ReplayStats stats = ReplayTrace(sim, trace);
+            std::cout << "events:        " << stats.events << "\n"
+                      << "rejected:      " << stats.rejected << "\n"
+                      << "seconds:       " << stats.seconds << "\n"
+                      << "events/second: " << static_cast<unsigned long long>(stats.EventsPerSecond()) << "\n";
+            return 0;
+        }
+        if (command == "profile" && argc == 4)
+        {
+            std::string format = argv[3];
+            if (format != "json" && format != "csv")
+            {
+                PrintUsage();
+                return 2;
+            }
+            TraceFile trace(argv[2]);
+            SimOS sim(trace.Header().numberOfDisks, trace.Header().amountOfRAM, trace.Header().pageSize,
+                std::max<int>(1, trace.Header().numberOfCores));
+            ReplayTrace(sim, trace);
+            if (!SimProfiler::ENABLED)
+            {
+                std::cerr << "traceTool was built without SIMOS_PROFILING, counters are empty\n";
+            }
+            if (format == "json")
+                sim.Profiler().WriteJson(std::cout);
+            else
+                sim.Profiler().WriteCsv(std::cout);
+            return 0;
+        }
+        if (command == "tlb" && (argc == 5 || argc == 6))
+        {
+            TraceFile trace(argv[2]);
+            SimOptions options;
+            options.numberOfCores = std::max<int>(1, trace.Header().numberOfCores);
+            options.tlb.sets = std::stoul(argv[3]);
+            options.tlb.ways = std::stoul(argv[4]);
+            options.tlb.tagged = argc == 5 || std::string(argv[5]) != "flush";
+            SimOS sim(trace.Header().numberOfDisks, trace.Header().amountOfRAM, trace.Header().pageSize, options);
+            ReplayStats stats = ReplayTrace(sim, trace);
+
+            std::cout << "core,hits,misses,flushes,invalidations,hitRatio\n" << std::setprecision(6);
+            for (int core = 0; core < sim.NumberOfCores(); ++core)
+            {
+                TLBStats tlb = sim.GetTLBStats(core);
+                std::cout << core << "," << tlb.hits << "," << tlb.misses << "," << tlb.flushes << ","
+                          << tlb.invalidations << "," << tlb.HitRatio() << "\n";
+            }
+            std::cerr << "events/second: " << static_cast<unsigned long long>(stats.EventsPerSecond()) << "\n";
+            return 0;
+        }
+        if (command == "sweep" && (argc == 6 || argc == 7))
+        {
+            // Every combination of the lists, one SimOS each, run in parallel over one mapping of the trace
+            TraceFile trace(argv[2]);
+            SimOptions options;
+            options.numberOfCores = std::max<int>(1, trace.Header().numberOfCores);
+            std::vector<SweepConfig> configs = SweepGrid(ParseList<int>(argv[3]), ParseList<unsigned long long>(argv[4]),
+                ParseList<unsigned int>(argv[5]), options);
+            unsigned int threads = argc == 7 ? std::stoul(argv[6]) : 0;
+
+            auto start = std::chrono::steady_clock::now();
+            std::vector<SweepResult> results = RunSweep(trace, configs, threads);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            WriteSweepCsv(std::cout, results, &std::cerr);
+            std::cerr << configs.size() << " configurations in " << seconds << " seconds\n";
+            return 0;
+        }
+        if (command == "faults")
+        {
+            // Every algorithm for every RAM size, all fed by one pass over the trace
+            const std::vector<std::pair<ReplacementAlgorithm, const char*>> algorithms{
+                {ReplacementAlgorithm::LRU, "LRU"}, {ReplacementAlgorithm::FIFO, "FIFO"},
+                {ReplacementAlgorithm::Clock, "Clock"}, {ReplacementAlgorithm::ARC, "ARC"},
+                {ReplacementAlgorithm::WSClock, "WSClock"}};
+            // With --huge every run is repeated with huge pages for every fault, with --readahead with readahead
+            TraceFile trace(argv[2]);
+            std::vector<unsigned long long> hugePageSizes{0};
+            std::vector<unsigned int> readAheads{0};
+            std::vector<unsigned long long> sizes;
+            for (int arg = 3; arg < argc; ++arg)
+            {
+                if (std::string(argv[arg]) == "--huge" && arg + 1 < argc)
+                    hugePageSizes.push_back(std::stoull(argv[++arg]));
+                else if (std::string(argv[arg]) == "--readahead" && arg + 1 < argc)
+                    readAheads.push_back(std::stoul(argv[++arg]));
+                else
+                    sizes.push_back(std::stoull(argv[arg]));
+            }
+            if (sizes.empty())
+                sizes.push_back(trace.Header().amountOfRAM);
+
+            struct Run
+            {
+                unsigned long long ram;
+                unsigned long long hugePageSize;
+                unsigned int readAhead;
+                const char* algorithm;
+            };
+            std::vector<Run> runs;
+            std::vector<std::unique_ptr<SimOS>> owned;
+            std::vector<SimOS*> sims;
+            for (unsigned long long ram : sizes)
+            {
+                for (unsigned long long hugePageSize : hugePageSizes)
+                {
+                    for (unsigned int readAhead : readAheads)
+                    {
+                        for (const auto& algorithm : algorithms)
+                        {
+                            SimOptions options;
+                            options.numberOfCores = std::max<int>(1, trace.Header().numberOfCores);
+                            options.replacement = algorithm.first;
+                            options.hugePageSize = hugePageSize;
+                            options.hugePages = hugePageSize == 0 ? HugePageMode::Never : HugePageMode::Always;
+                            options.readAhead = readAhead;
+                            owned.push_back(std::make_unique<SimOS>(trace.Header().numberOfDisks, ram, trace.Header().pageSize, options));
+                            sims.push_back(owned.back().get());
+                            runs.push_back(Run{ram, hugePageSize, readAhead, algorithm.second});
+                        }
+                    }
+                }
+            }
+            ReplayTrace(sims, trace);
+
+            std::cout << "amountOfRAM,hugePageSize,readAhead,algorithm,accesses,faults,hugeFaults,evictions,compactions,faultRate,"
+                      << "prefetched,prefetchHits,prefetchAccuracy\n" << std::setprecision(6);
+            for (std::size_t i = 0; i < sims.size(); ++i)
+            {
+                MemoryStats stats = sims[i]->GetMemoryStats();
+                std::cout << runs[i].ram << "," << runs[i].hugePageSize << "," << runs[i].readAhead << "," << runs[i].algorithm << ","
+                          << stats.accesses << "," << stats.faults << "," << stats.hugeFaults << "," << stats.evictions << ","
+                          << stats.compactions << "," << stats.FaultRate() << "," << stats.prefetched << ","
+                          << stats.prefetchHits << "," << stats.PrefetchAccuracy() << "\n";
+            }
+            return 0;
+        }
+    }
+    catch (const std::exception& err)
+    {
+        std::cerr << err.what();
+        return 1;
+    }
+    PrintUsage();
+    return 2;
+}
@@ -0,0 +1,39 @@
+#include "workload.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+std::vector<Job> GenerateWorkload(const WorkloadConfig& config, int numberOfDisks)
+{
+    if (!(config.meanInterarrival > 0.0) || !(config.meanBurst > 0.0) || !(config.meanBursts >= 1.0)
+        || numberOfDisks < 1 || config.fileBlocks == 0 || config.maxReadBlocks == 0)
+    {
+        throw std::invalid_argument("Workload needs positive means, a disk and blocks to read\n");
+    }
+    std::mt19937_64 random(config.seed);
+    std::exponential_distribution<double> interarrival(1.0 / config.meanInterarrival);
+    std::exponential_distribution<double> burst(1.0 / config.meanBurst);
+    std::geometric_distribution<unsigned long long> extraBursts(1.0 / config.meanBursts);
+    std::uniform_int_distribution<int> disk(0, numberOfDisks - 1);
+    std::uniform_int_distribution<unsigned long long> block(0, config.fileBlocks - 1);
+    std::uniform_int_distribution<unsigned long long> blocks(1, config.maxReadBlocks);
+
+    std::vector<Job> jobs(config.jobs);
+    double now = 0.0;
+    for (Job& job : jobs)
+    {
+        now += interarrival(random);
+        job.arrival = static_cast<unsigned long long>(now);
+        job.bursts.resize(1 + extraBursts(random));
+        for (Burst& next : job.bursts)
+        {
+            next.cpuTime = std::max(1ULL, static_cast<unsigned long long>(std::ceil(burst(random))));
+            next.disk = disk(random);
+            next.block = block(random);
+            next.blocks = blocks(random);
+        }
+    }
+    return jobs;
+}
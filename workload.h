@@ -0,0 +1,49 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <vector>
+
+/**
+ * CPU burst of a job, followed by a read of blocks blocks from block on disk unless it is the last burst.
+ * Times are in ticks of the simulated clock.
+ */
+struct Burst
+{
+    unsigned long long cpuTime {1};
+    int disk {0};
+    unsigned long long block {0};
+    unsigned long long blocks {1};
+};
+
+/**
+ * Process arriving at time arrival. It alternates its CPU bursts with their disk reads and exits after
+ * the last burst.
+ */
+struct Job
+{
+    unsigned long long arrival {0};
+    std::vector<Burst> bursts;
+};
+
+/**
+ * Synthetic open workload. Arrivals are a Poisson process, CPU bursts are exponentially distributed and
+ * the number of bursts per job is geometric. Reads go to a uniformly chosen disk and block.
+ */
+struct WorkloadConfig
+{
+    unsigned long long jobs {1000};
+    double meanInterarrival {20.0};
+    double meanBurst {8.0};                 // rounded up to whole ticks, at least 1
+    double meanBursts {4.0};                // at least 1
+    unsigned long long fileBlocks {1 << 20};
+    unsigned long long maxReadBlocks {8};   // reads are 1 to maxReadBlocks blocks long
+    unsigned long long seed {1};
+};
+
+/**
+ * Jobs in arrival order, the same ones for the same config and number of disks.
+ * Throws std::invalid_argument if a mean is not positive or there is no disk.
+ */
+std::vector<Job> GenerateWorkload(const WorkloadConfig& config, int numberOfDisks);
+
+#endif